@@ -0,0 +1,227 @@
+#include "CpuDispatch.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#if defined(__x86_64__)
+#define CRYPTO_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+namespace CpuDispatch {
+    namespace {
+        void xor_bytes_scalar(unsigned char* a, const unsigned char* b, size_t size) {
+            size_t i = 0;
+            for (; i + 8 <= size; i += 8) {
+                uint64_t x, y;
+                std::memcpy(&x, a + i, 8);
+                std::memcpy(&y, b + i, 8);
+                x ^= y;
+                std::memcpy(a + i, &x, 8);
+            }
+            for (; i < size; ++i) {
+                a[i] ^= b[i];
+            }
+        }
+
+        uint64_t pext_scalar(uint64_t input, uint64_t mask) {
+            uint64_t result = 0;
+            for (uint64_t bit = 1; mask != 0; bit <<= 1) {
+                uint64_t lowest = mask & (~mask + 1);
+                if (input & lowest) {
+                    result |= bit;
+                }
+                mask ^= lowest;
+            }
+            return result;
+        }
+
+        uint64_t pdep_scalar(uint64_t input, uint64_t mask) {
+            uint64_t result = 0;
+            for (uint64_t bit = 1; mask != 0; bit <<= 1) {
+                uint64_t lowest = mask & (~mask + 1);
+                if (input & bit) {
+                    result |= lowest;
+                }
+                mask ^= lowest;
+            }
+            return result;
+        }
+
+        uint64_t gather_scatter_bits_scalar(uint64_t input, const uint64_t* source_masks, const uint64_t* target_masks, size_t groups) {
+            uint64_t result = 0;
+            for (size_t g = 0; g < groups; ++g) {
+                result |= pdep_scalar(pext_scalar(input, source_masks[g]), target_masks[g]);
+            }
+            return result;
+        }
+
+#ifdef CRYPTO_X86
+        __attribute__((target("bmi2")))
+        uint64_t gather_scatter_bits_bmi2(uint64_t input, const uint64_t* source_masks, const uint64_t* target_masks, size_t groups) {
+            uint64_t result = 0;
+            for (size_t g = 0; g < groups; ++g) {
+                result |= _pdep_u64(_pext_u64(input, source_masks[g]), target_masks[g]);
+            }
+            return result;
+        }
+
+        __attribute__((target("sse2")))
+        void xor_bytes_sse2(unsigned char* a, const unsigned char* b, size_t size) {
+            size_t i = 0;
+            for (; i + 16 <= size; i += 16) {
+                __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+                __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(a + i), _mm_xor_si128(x, y));
+            }
+            xor_bytes_scalar(a + i, b + i, size - i);
+        }
+
+        __attribute__((target("avx2")))
+        void xor_bytes_avx2(unsigned char* a, const unsigned char* b, size_t size) {
+            size_t i = 0;
+            for (; i + 32 <= size; i += 32) {
+                __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+                __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(a + i), _mm256_xor_si256(x, y));
+            }
+            xor_bytes_sse2(a + i, b + i, size - i);
+        }
+
+        __attribute__((target("avx512f")))
+        void xor_bytes_avx512(unsigned char* a, const unsigned char* b, size_t size) {
+            size_t i = 0;
+            for (; i + 64 <= size; i += 64) {
+                __m512i x = _mm512_loadu_si512(a + i);
+                __m512i y = _mm512_loadu_si512(b + i);
+                _mm512_storeu_si512(a + i, _mm512_xor_si512(x, y));
+            }
+            xor_bytes_avx2(a + i, b + i, size - i);
+        }
+#endif
+
+#ifdef CRYPTO_X86
+        // AMD (и Hygon) до семейства 19h (Zen 3) - Excavator, Zen 1, Zen 2 - исполняют pext/pdep микрокодом
+        bool microcoded_pext() {
+            unsigned max_leaf, ebx, ecx, edx;
+            if (!__get_cpuid(0, &max_leaf, &ebx, &ecx, &edx) || max_leaf < 1) {
+                return false;
+            }
+            char vendor[12];
+            std::memcpy(vendor, &ebx, 4);
+            std::memcpy(vendor + 4, &edx, 4);
+            std::memcpy(vendor + 8, &ecx, 4);
+            const std::string name(vendor, sizeof(vendor));
+            if (name != "AuthenticAMD" && name != "HygonGenuine") {
+                return false;
+            }
+            unsigned eax;
+            __get_cpuid(1, &eax, &ebx, &ecx, &edx);
+            unsigned family = (eax >> 8) & 0xF;
+            if (family == 0xF) {
+                family += (eax >> 20) & 0xFF;
+            }
+            return family < 0x19;
+        }
+#endif
+
+        CpuFeatures detect_features() {
+            CpuFeatures features;
+#ifdef CRYPTO_X86
+            __builtin_cpu_init();
+            features.sse2 = __builtin_cpu_supports("sse2");
+            features.ssse3 = __builtin_cpu_supports("ssse3");
+            features.avx2 = __builtin_cpu_supports("avx2");
+            features.avx512 = __builtin_cpu_supports("avx512f");
+            features.bmi2 = __builtin_cpu_supports("bmi2");
+            features.slow_pext = features.bmi2 && microcoded_pext();
+#endif
+            return features;
+        }
+
+        CpuTier best_tier(const CpuFeatures& features) {
+            if (features.avx512) return CpuTier::AVX512;
+            if (features.avx2) return CpuTier::AVX2;
+            if (features.ssse3) return CpuTier::SSSE3;
+            if (features.sse2) return CpuTier::SSE2;
+            return CpuTier::SCALAR;
+        }
+
+        CpuTier tier_from_env(CpuTier detected) {
+            const char* value = std::getenv("CRYPTO_CPU_TIER");
+            if (value == nullptr || *value == '\0') {
+                return detected;
+            }
+            const std::string name(value);
+            CpuTier requested;
+            if (name == "scalar") requested = CpuTier::SCALAR;
+            else if (name == "sse2") requested = CpuTier::SSE2;
+            else if (name == "ssse3") requested = CpuTier::SSSE3;
+            else if (name == "avx2") requested = CpuTier::AVX2;
+            else if (name == "avx512") requested = CpuTier::AVX512;
+            else {
+                std::cout << "Unknown CRYPTO_CPU_TIER value: " << name << ". Using " << tier_name(detected) << "." << std::endl;
+                return detected;
+            }
+            if (requested > detected) {
+                std::cout << "CRYPTO_CPU_TIER=" << name << " is not supported by this CPU. Using " << tier_name(detected) << "." << std::endl;
+                return detected;
+            }
+            return requested;
+        }
+
+        SymmetricKernels select_kernels() {
+            const CpuFeatures& features = cpu_features();
+            SymmetricKernels k{};
+            k.tier = tier_from_env(best_tier(features));
+            // BMI2 появился вместе с AVX2; при принудительно пониженном уровне его тоже не используем.
+            // Микрокодные pext/pdep медленнее таблицы перестановки - на таких процессорах остаются скалярные ядра
+            k.bmi2 = features.bmi2 && !features.slow_pext && k.tier >= CpuTier::AVX2;
+            k.xor_bytes = xor_bytes_scalar;
+            k.gather_scatter_bits = gather_scatter_bits_scalar;
+#ifdef CRYPTO_X86
+            if (k.bmi2) {
+                k.gather_scatter_bits = gather_scatter_bits_bmi2;
+            }
+            switch (k.tier) {
+                case CpuTier::AVX512:
+                    k.xor_bytes = xor_bytes_avx512;
+                    break;
+                case CpuTier::AVX2:
+                    k.xor_bytes = xor_bytes_avx2;
+                    break;
+                case CpuTier::SSSE3:
+                case CpuTier::SSE2:
+                    k.xor_bytes = xor_bytes_sse2;
+                    break;
+                default:
+                    break;
+            }
+#endif
+            return k;
+        }
+    }
+
+    const CpuFeatures& cpu_features() {
+        static const CpuFeatures features = detect_features();
+        return features;
+    }
+
+    const SymmetricKernels& kernels() {
+        static const SymmetricKernels selected = select_kernels();
+        return selected;
+    }
+
+    const char* tier_name(CpuTier tier) {
+        switch (tier) {
+            case CpuTier::SSE2: return "sse2";
+            case CpuTier::SSSE3: return "ssse3";
+            case CpuTier::AVX2: return "avx2";
+            case CpuTier::AVX512: return "avx512";
+            case CpuTier::SCALAR:
+            default: return "scalar";
+        }
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef CRYPTOGRAPHY_CPUDISPATCH_H
+#define CRYPTOGRAPHY_CPUDISPATCH_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Выбор реализаций вычислительных ядер по возможностям процессора.
+// Набор инструкций определяется один раз при первом обращении; переменная окружения
+// CRYPTO_CPU_TIER=scalar|sse2|ssse3|avx2|avx512 ограничивает уровень сверху (для тестов и замеров).
+namespace CpuDispatch {
+
+    enum class CpuTier {
+        SCALAR,
+        SSE2,
+        SSSE3,
+        AVX2,
+        AVX512
+    };
+
+    struct CpuFeatures {
+        bool sse2 = false;
+        bool ssse3 = false;
+        bool avx2 = false;
+        bool avx512 = false;
+        bool bmi2 = false;
+        // pext/pdep есть, но выполняются микрокодом (AMD до Zen 3: десятки-сотни тактов против 3)
+        bool slow_pext = false;
+    };
+
+    struct SymmetricKernels {
+        CpuTier tier;
+        bool bmi2;      // используются pext/pdep (есть BMI2, он быстрый, уровень не ниже avx2)
+        // a[i] ^= b[i], i < size
+        void (*xor_bytes)(unsigned char* a, const unsigned char* b, size_t size);
+        // Сумма pdep(pext(input, source_masks[g]), target_masks[g]) по группам g < groups
+        uint64_t (*gather_scatter_bits)(uint64_t input, const uint64_t* source_masks, const uint64_t* target_masks, size_t groups);
+    };
+
+    const CpuFeatures& cpu_features();
+    const SymmetricKernels& kernels();
+    const char* tier_name(CpuTier tier);
+}
+
+#endif //CRYPTOGRAPHY_CPUDISPATCH_H
@@ -8,18 +8,6 @@
 
 
 namespace DES_Implementation {
-    bool get_bit(const byte_array &data, size_t index) {
-        return (data[index / 8] >> (7 - (index % 8))) & 1;
-    }
-
-    void set_bit(byte_array &data, size_t index, bool value) {
-        if (value) {
-            data[index / 8] |= (1 << (7 - (index % 8)));
-        } else {
-            data[index / 8] &= ~(1 << (7 - (index % 8)));
-        }
-    }
-
     void xor_bytes(std::vector<unsigned char>& a, const std::vector<unsigned char>& b) {
         if (a.size() != b.size()) {
             std::cout << "XOR vectors must have the same size." << std::endl;
@@ -42,6 +30,30 @@ namespace DES_Implementation {
         const int S_BOXES[8][4][16] = {{{14,4,13,1,2,15,11,8,3,10,6,12,5,9,0,7},{0,15,7,4,14,2,13,1,10,6,12,11,9,5,3,8},{4,1,14,8,13,6,2,11,15,12,9,7,3,10,5,0},{15,12,8,2,4,9,1,7,5,11,3,14,10,0,6,13}},{{15,1,8,14,6,11,3,4,9,7,2,13,12,0,5,10},{3,13,4,7,15,2,8,14,12,0,1,10,6,9,11,5},{0,14,7,11,10,4,13,1,5,8,12,6,9,3,2,15},{13,8,10,1,3,15,4,2,11,6,7,12,0,5,14,9}},{{10,0,9,14,6,3,15,5,1,13,12,7,11,4,2,8},{13,7,0,9,3,4,6,10,2,8,5,14,12,11,15,1},{13,6,4,9,8,15,3,0,11,1,2,12,5,10,14,7},{1,10,13,0,6,9,8,7,4,15,14,3,11,5,2,12}},{{7,13,14,3,0,6,9,10,1,2,8,5,11,12,4,15},{13,8,11,5,6,15,0,3,4,7,2,12,1,10,14,9},{10,6,9,0,12,11,7,13,15,1,3,14,5,2,8,4},{3,15,0,6,10,1,13,8,9,4,5,11,12,7,2,14}},{{2,12,4,1,7,10,11,6,8,5,3,15,13,0,14,9},{14,11,2,12,4,7,13,1,5,0,15,10,3,9,8,6},{4,2,1,11,10,13,7,8,15,9,12,5,6,3,0,14},{11,8,12,7,1,14,2,13,6,15,0,9,10,4,5,3}},{{12,1,10,15,9,2,6,8,0,13,3,4,14,7,5,11},{10,15,4,2,7,12,9,5,6,1,13,14,0,11,3,8},{9,14,15,5,2,8,12,3,7,0,4,10,1,13,11,6},{4,3,2,12,9,5,15,10,11,14,1,7,6,0,8,13}},{{4,11,2,14,15,0,8,13,3,12,9,7,5,10,6,1},{13,0,11,7,4,9,1,10,14,3,5,12,2,15,8,6},{1,4,11,13,12,3,7,14,10,15,6,8,0,5,9,2},{6,11,13,8,1,4,10,7,9,5,0,15,14,2,3,12}},{{13,2,8,4,6,15,11,1,10,9,3,14,5,0,12,7},{1,15,13,8,10,3,7,4,12,5,6,11,0,14,9,2},{7,11,4,1,9,12,14,2,0,6,10,13,15,3,5,8},{2,1,14,7,4,10,8,13,15,12,9,0,3,5,6,11}}};
     }
 
+    // Таблицы DES, скомпилированные при первом обращении: выбор стратегии читает CpuDispatch,
+    // поэтому строить их при статической инициализации нельзя - порядок между единицами трансляции не задан
+    namespace {
+        struct CompiledTables {
+            CompiledPermutation IP{DES_Tables::IP, BitDir::BIG_END, BitBase::ONE_BASE, 8};
+            CompiledPermutation FP{DES_Tables::FP, BitDir::BIG_END, BitBase::ONE_BASE, 8};
+            CompiledPermutation E{DES_Tables::E, BitDir::BIG_END, BitBase::ONE_BASE, 4};
+            CompiledPermutation P{DES_Tables::P, BitDir::BIG_END, BitBase::ONE_BASE, 4};
+            CompiledPermutation PC1{DES_Tables::PC1, BitDir::BIG_END, BitBase::ONE_BASE, 8};
+            CompiledPermutation PC2{DES_Tables::PC2, BitDir::BIG_END, BitBase::ONE_BASE, 7};
+        };
+
+        const CompiledTables& compiled_tables() {
+            static const CompiledTables tables;
+            return tables;
+        }
+    }
+
+    byte_array apply_compiled(const CompiledPermutation& permutation, const byte_array& block) {
+        byte_array result(permutation.outputBits() / 8);
+        word_to_bytes(permutation.apply(bytes_to_word(block.data(), block.size())), result.data(), result.size());
+        return result;
+    }
+
     bool check_des_parity_bits(const byte_array& key) {
         if (key.size() != 8) {
             return false;
@@ -76,36 +88,22 @@ namespace DES_Implementation {
             std::cout << "Invalid DES key: parity bits are incorrect." << std::endl;
         }
 
-        byte_array key_56 = permute(masterKey, DES_Tables::PC1, BitDir::BIG_END, BitBase::ONE_BASE);
+        const uint64_t key_56 = compiled_tables().PC1.apply(bytes_to_word(masterKey.data(), std::min<size_t>(masterKey.size(), 8)));
         round_keys_array round_keys;
+        round_keys.reserve(16);
+        // Сдвиги накапливаются: C_i и D_i получаются из C_{i-1} и D_{i-1}, а не из C_0 и D_0
+        uint32_t c_half = static_cast<uint32_t>(key_56 >> 28) & 0x0FFFFFFF;
+        uint32_t d_half = static_cast<uint32_t>(key_56) & 0x0FFFFFFF;
         for (int i = 0; i < 16; ++i) {
-            uint32_t c_half = 0;
-            uint32_t d_half = 0;
-            for (int i = 0; i < 28; ++i) {
-                if (get_bit(key_56, i)){
-                    c_half |= (1 << (27 - i));
-                }
-                if (get_bit(key_56, i + 28)) {
-                    d_half |= (1 << (27 - i));
-                }
-            }
             for (int s = 0; s < DES_Tables::SHIFTS[i]; ++s) {
                 c_half = ((c_half << 1) | (c_half >> 27)) & 0x0FFFFFFF;
                 d_half = ((d_half << 1) | (d_half >> 27)) & 0x0FFFFFFF;
             }
 
-            byte_array combined_56(7, 0);
-            for (int j = 0; j < 28; ++j) {
-                if ((c_half >> (27 - j)) & 1){
-                    set_bit(combined_56, j, true);
-                }
-                if ((d_half >> (27 - j)) & 1){
-                    set_bit(combined_56, j + 28, true);
-                }
-            }
-
-            byte_array round_key = permute(combined_56, DES_Tables::PC2, BitDir::BIG_END, BitBase::ONE_BASE);
-            round_keys.push_back(round_key);
+            const uint64_t combined_56 = (static_cast<uint64_t>(c_half) << 28) | d_half;
+            byte_array round_key(6);
+            word_to_bytes(compiled_tables().PC2.apply(combined_56), round_key.data(), round_key.size());
+            round_keys.push_back(std::move(round_key));
         }
         return round_keys;
     }
@@ -117,28 +115,32 @@ namespace DES_Implementation {
         if (roundKey.size() != 6) {
             std::cout << "DES round key must be 48 bits." << std::endl;
         }
-        byte_array expanded = permute(half_block, DES_Tables::E, BitDir::BIG_END, BitBase::ONE_BASE);
-        xor_bytes(expanded, roundKey);
+        uint64_t half = bytes_to_word(half_block.data(), std::min<size_t>(half_block.size(), 4));
+        uint64_t key = bytes_to_word(roundKey.data(), std::min<size_t>(roundKey.size(), 6));
+        byte_array final_result(4);
+        word_to_bytes(applyWord(static_cast<uint32_t>(half), key), final_result.data(), final_result.size());
+        return final_result;
+    }
 
-        byte_array s_output(4, 0);
+    uint32_t DESRoundFunction::applyWord(uint32_t half_block, uint64_t roundKey) {
+        uint64_t expanded = compiled_tables().E.apply(half_block) ^ roundKey;
+
+        uint64_t s_output = 0;
         for (int i = 0; i < 8; ++i) {
-            int six_bits = 0;
-            for (int j = 0; j < 6; ++j) {
-                if(get_bit(expanded,i*6 + j)){
-                    six_bits|=(1 << (5 - j));//B^i блок
-                }
-            }
+            int six_bits = static_cast<int>(expanded >> (42 - 6 * i)) & 0x3F;//B^i блок
             int row = ((six_bits >> 5) & 1)*2 + (six_bits & 1);
             int col = (six_bits >> 1) & 0x0F;
-            unsigned char s_val=DES_Tables::S_BOXES[i][row][col];//B'^i
-            for(int j = 0; j < 4; ++j){
-                if((s_val >> (3 - j)) & 1){
-                    set_bit(s_output,i*4+j,true);
-                }
-            }
+            s_output = (s_output << 4) | DES_Tables::S_BOXES[i][row][col];//B'^i
         }
-        byte_array final_result = permute(s_output, DES_Tables::P, BitDir::BIG_END, BitBase::ONE_BASE);
-        return final_result;
+        return static_cast<uint32_t>(compiled_tables().P.apply(s_output));
+    }
+
+    uint64_t initial_permutation(uint64_t block) {
+        return compiled_tables().IP.apply(block);
+    }
+
+    uint64_t final_permutation(uint64_t block) {
+        return compiled_tables().FP.apply(block);
     }
 
     DES::DES() {
@@ -156,16 +158,16 @@ namespace DES_Implementation {
     }
 
     byte_array DES::encryptBlock(const byte_array& block) {
-        byte_array permuted = permute(block, DES_Tables::IP, BitDir::BIG_END, BitBase::ONE_BASE);
+        byte_array permuted = apply_compiled(compiled_tables().IP, block);
         byte_array feistel_out = m_feistel_network->encryptBlock(permuted);
-        byte_array ciphertext = permute(feistel_out, DES_Tables::FP, BitDir::BIG_END, BitBase::ONE_BASE);
+        byte_array ciphertext = apply_compiled(compiled_tables().FP, feistel_out);
         return ciphertext;
     }
 
     byte_array DES::decryptBlock(const byte_array& block) {
-        byte_array permuted = permute(block, DES_Tables::IP, BitDir::BIG_END, BitBase::ONE_BASE);
+        byte_array permuted = apply_compiled(compiled_tables().IP, block);
         byte_array feistel_out = m_feistel_network->decryptBlock(permuted);
-        byte_array plaintext = permute(feistel_out, DES_Tables::FP, BitDir::BIG_END, BitBase::ONE_BASE);
+        byte_array plaintext = apply_compiled(compiled_tables().FP, feistel_out);
         return plaintext;
     }
 
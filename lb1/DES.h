@@ -8,6 +8,11 @@
 #define CRYPTOGRAPHY_DES_H
 
 namespace DES_Implementation {
+    // Таблицы стандарта (FIPS 46-3), нумерация битов с 1 от старшего
+    namespace DES_Tables {
+        extern const std::vector<int> IP, FP, E, P, PC1, PC2;
+    }
+
     class DESKeyExpander : public IKeyExpander {
     public:
         std::vector<std::vector<unsigned char>> generateRoundKeys(const std::vector<unsigned char>& masterKey) override;
@@ -16,8 +21,14 @@ namespace DES_Implementation {
     class DESRoundFunction : public IRoundFunction {
     public:
         std::vector<unsigned char> apply(const std::vector<unsigned char>& half_block, const std::vector<unsigned char>& roundKey) override;
+        // То же на машинных словах: 32-битная половина блока и 48-битный ключ раунда
+        static uint32_t applyWord(uint32_t half_block, uint64_t roundKey);
     };
 
+    // IP и FP над 64-битным блоком (байт 0 - старший)
+    uint64_t initial_permutation(uint64_t block);
+    uint64_t final_permutation(uint64_t block);
+
     class DES : public ISymmetricCipher {
     public:
         DES();
@@ -6,6 +6,8 @@
 #include <stdexcept>
 #include <fstream>
 #include <algorithm>
+#include <deque>
+#include <thread>
 
 #ifdef _OPENMP
 #include <omp.h>
@@ -19,10 +21,20 @@ CipherContext::CipherContext(
         PaddingScheme padding,
         std::optional<byte_array> iv,
         ExtraParams params
+)   : CipherContext(std::move(algorithm), key, mode, padding, std::move(iv), toModeParams(mode, params))
+{
+}
+
+CipherContext::CipherContext(
+        std::unique_ptr<ISymmetricCipher> algorithm,
+        const byte_array& key,
+        CipherMode mode,
+        PaddingScheme padding,
+        std::optional<byte_array> iv,
+        ModeParams params
 )   : m_algorithm(std::move(algorithm)),
       m_mode(mode),
-      m_padding(padding),
-      m_params(std::move(params))
+      m_padding(padding)
 {
     bool iv_is_required;
     switch (m_mode) {
@@ -43,10 +55,10 @@ CipherContext::CipherContext(
 
     if (iv_is_required) {
         if (!iv.has_value()) {
-            std::cout << "This encryption mode requires an Initialization Vector (IV)." << std::endl;
+            throw std::invalid_argument("This encryption mode requires an Initialization Vector (IV).");
         }
         if (iv->size() != m_algorithm->getBlockSize()) {
-            std::cout << "IV size must be equal to the block size of the algorithm."<< std::endl;
+            throw std::invalid_argument("IV size must be equal to the block size of the algorithm.");
         }
 
         m_iv = *iv;
@@ -57,9 +69,38 @@ CipherContext::CipherContext(
         }
 
     }
+
+    if (m_mode == CipherMode::RANDOM_DELTA) {
+        const auto* delta_params = std::get_if<RandomDeltaParams>(&params);
+        if (delta_params == nullptr) {
+            throw std::invalid_argument("RANDOM_DELTA mode requires a delta parameter.");
+        }
+        if (delta_params->delta.size() != m_algorithm->getBlockSize()) {
+            throw std::invalid_argument("Delta size must be equal to the block size of the algorithm.");
+        }
+        if (delta_params->delta.size() > MAX_BLOCK_SIZE) {
+            throw std::invalid_argument("RANDOM_DELTA supports blocks of at most " + std::to_string(MAX_BLOCK_SIZE) + " bytes.");
+        }
+        std::copy(delta_params->delta.begin(), delta_params->delta.end(), m_delta.begin());
+    }
     m_algorithm->setKey(key);
 }
 
+ModeParams CipherContext::toModeParams(CipherMode mode, const ExtraParams& params) {
+    if (mode != CipherMode::RANDOM_DELTA) {
+        return std::monostate{};
+    }
+    auto it = params.find("delta");
+    if (it == params.end()) {
+        return std::monostate{};
+    }
+    const auto* delta = std::any_cast<byte_array>(&it->second);
+    if (delta == nullptr) {
+        throw std::invalid_argument("Extra parameter 'delta' must be a byte array.");
+    }
+    return RandomDeltaParams{*delta};
+}
+
 
 void CipherContext::applyPadding(std::vector<unsigned char>& data) {
     size_t block_size = getBlockSize();
@@ -136,79 +177,183 @@ byte_array CipherContext::decryptBlock(const byte_array& block) {
     return m_algorithm->decryptBlock(block);
 }
 
-std::future<void> CipherContext::encrypt(const std::vector<unsigned char>& input, std::vector<unsigned char>& output) {
-    return std::async(std::launch::async, [this, &input, &output]() {
-        std::vector<unsigned char> data = input;
-        applyPadding(data);
-        const size_t block_size = getBlockSize();
-        const size_t num_blocks = data.size() / block_size;
-        output.resize(data.size());
-
-        if (m_mode == CipherMode::ECB || m_mode == CipherMode::CTR) {
-#pragma omp parallel for
-            for (long long i = 0; i < num_blocks; ++i) {
-                std::vector<unsigned char> block(data.begin() + i * block_size, data.begin() + (i + 1) * block_size);
-                std::vector<unsigned char> encrypted_block;
-                if (m_mode == CipherMode::ECB) {
-                    encrypted_block = encryptBlock(block);
-                }
-                else {
-                    std::vector<unsigned char> counter_block = m_iv;
-                    for (long long j = 0; j < i; ++j) {
-                        for (int k = counter_block.size() - 1; k >= 0; --k){
-                            if (++counter_block[k] != 0)
-                                break;
-                        }
-                    }
-                    encrypted_block = encryptBlock(counter_block);
-                    xor_bytes(encrypted_block, block);
-                }
-                std::copy(encrypted_block.begin(), encrypted_block.end(), output.begin() + i * block_size);
+void CipherContext::encryptBlocks(const byte_array& data, byte_array& output, byte_array& feedback, uint64_t first_block,
+                                  bool parallel_blocks) {
+    const size_t block_size = getBlockSize();
+    const size_t num_blocks = data.size() / block_size;
+    const long long block_count = static_cast<long long>(num_blocks); // индекс цикла OpenMP - знаковый
+    output.resize(num_blocks * block_size);
+
+    if (m_mode == CipherMode::ECB) {
+#pragma omp parallel for if(parallel_blocks)
+        for (long long i = 0; i < block_count; ++i) {
+            std::vector<unsigned char> block(data.begin() + i * block_size, data.begin() + (i + 1) * block_size);
+            std::vector<unsigned char> encrypted_block = encryptBlock(block);
+            std::copy(encrypted_block.begin(), encrypted_block.end(), output.begin() + i * block_size);
+        }
+        return;
+    }
+    if (m_mode == CipherMode::CTR) {
+        // сначала гамма для всего буфера, затем один XOR через выбранное по CPU ядро
+#pragma omp parallel for if(parallel_blocks)
+        for (long long i = 0; i < block_count; ++i) {
+            std::vector<unsigned char> counter_block = m_iv;
+            add_to_counter(counter_block, first_block + i);
+            std::vector<unsigned char> keystream_block = encryptBlock(counter_block);
+            std::copy(keystream_block.begin(), keystream_block.end(), output.begin() + i * block_size);
+        }
+        CpuDispatch::kernels().xor_bytes(output.data(), data.data(), output.size());
+        return;
+    }
+
+    for (size_t i = 0; i < num_blocks; ++i) {
+        std::vector<unsigned char> block(data.begin() + i * block_size, data.begin() + (i + 1) * block_size);
+        std::vector<unsigned char> encrypted_block;
+        switch (m_mode) {
+            case CipherMode::CBC:
+                xor_bytes(block, feedback);
+                encrypted_block = encryptBlock(block);
+                feedback = encrypted_block;
+                break;
+            case CipherMode::PCBC: {
+                std::vector<unsigned char> plaintext_copy = block;
+                xor_bytes(block, feedback);
+                encrypted_block = encryptBlock(block);
+                feedback = encrypted_block;
+                xor_bytes(feedback, plaintext_copy);
+                break;
+            }
+            case CipherMode::CFB:
+                encrypted_block = encryptBlock(feedback);
+                xor_bytes(encrypted_block, block);
+                feedback = encrypted_block;
+                break;
+            case CipherMode::OFB:
+                feedback = encryptBlock(feedback);
+                encrypted_block = block;
+                xor_bytes(encrypted_block, feedback);
+                break;
+            case CipherMode::RANDOM_DELTA: {
+                xor_bytes(block, feedback);
+                encrypted_block = encryptBlock(block);
+                feedback = encrypted_block;
+                xorDelta(feedback);
+                break;
             }
+            default:
+                break;
         }
-        else {
-            std::vector<unsigned char> feedback = m_iv;
-            for (size_t i = 0; i < num_blocks; ++i) {
-                std::vector<unsigned char> block(data.begin() + i * block_size, data.begin() + (i + 1) * block_size);
-                std::vector<unsigned char> encrypted_block;
-                switch (m_mode) {
-                    case CipherMode::CBC:
-                        xor_bytes(block, feedback);
-                        encrypted_block = encryptBlock(block);
-                        feedback = encrypted_block;
-                        break;
-                    case CipherMode::PCBC: {
-                        std::vector<unsigned char> plaintext_copy = block;
-                        xor_bytes(block, feedback);
-                        encrypted_block = encryptBlock(block);
-                        feedback = encrypted_block;
-                        xor_bytes(feedback, plaintext_copy);
-                        break;
-                    }
-                    case CipherMode::CFB:
-                        encrypted_block = encryptBlock(feedback);
-                        xor_bytes(encrypted_block, block);
-                        feedback = encrypted_block;
-                        break;
-                    case CipherMode::OFB:
-                        feedback = encryptBlock(feedback);
-                        encrypted_block = block;
-                        xor_bytes(encrypted_block, feedback);
-                        break;
-                    case CipherMode::RANDOM_DELTA: {
-                        const auto& delta = std::any_cast<std::vector<unsigned char>>(m_params.at("delta"));
-                        xor_bytes(block, feedback);
-                        encrypted_block = encryptBlock(block);
-                        feedback = encrypted_block;
-                        xor_bytes(feedback, delta);
-                        break;
-                    }
-                    default:
-                        break;
-                }
-                std::copy(encrypted_block.begin(), encrypted_block.end(), output.begin() + i * block_size);
+        std::copy(encrypted_block.begin(), encrypted_block.end(), output.begin() + i * block_size);
+    }
+}
+
+void CipherContext::decryptBlocks(const byte_array& input, byte_array& output, byte_array& feedback, uint64_t first_block,
+                                  bool parallel_blocks) {
+    const size_t block_size = getBlockSize();
+    const size_t num_blocks = input.size() / block_size;
+    const long long block_count = static_cast<long long>(num_blocks); // индекс цикла OpenMP - знаковый
+    output.resize(num_blocks * block_size);
+
+    if (m_mode == CipherMode::ECB) {
+#pragma omp parallel for if(parallel_blocks)
+        for (long long i = 0; i < block_count; ++i) {
+            std::vector<unsigned char> block(input.begin() + i * block_size, input.begin() + (i + 1) * block_size);
+            std::vector<unsigned char> decrypted_block = decryptBlock(block);
+            std::copy(decrypted_block.begin(), decrypted_block.end(), output.begin() + i * block_size);
+        }
+        return;
+    }
+    if (m_mode == CipherMode::CTR) {
+        // сначала гамма для всего буфера, затем один XOR через выбранное по CPU ядро
+#pragma omp parallel for if(parallel_blocks)
+        for (long long i = 0; i < block_count; ++i) {
+            std::vector<unsigned char> counter_block = m_iv;
+            add_to_counter(counter_block, first_block + i);
+            std::vector<unsigned char> keystream_block = encryptBlock(counter_block);
+            std::copy(keystream_block.begin(), keystream_block.end(), output.begin() + i * block_size);
+        }
+        CpuDispatch::kernels().xor_bytes(output.data(), input.data(), output.size());
+        return;
+    }
+
+    for (size_t i = 0; i < num_blocks; ++i) {
+        std::vector<unsigned char> block(input.begin() + i * block_size, input.begin() + (i + 1) * block_size);
+        std::vector<unsigned char> decrypted_block;
+        switch (m_mode) {
+            case CipherMode::CBC:
+                decrypted_block = decryptBlock(block);
+                xor_bytes(decrypted_block, feedback);
+                feedback = block;
+                break;
+            case CipherMode::PCBC: {
+                std::vector<unsigned char> ciphertext_copy = block;
+                decrypted_block = decryptBlock(block);
+                xor_bytes(decrypted_block, feedback);
+                feedback = decrypted_block;
+                xor_bytes(feedback, ciphertext_copy);
+                break;
             }
+            case CipherMode::CFB:
+                decrypted_block = encryptBlock(feedback);
+                xor_bytes(decrypted_block, block);
+                feedback = block;
+                break;
+            case CipherMode::OFB:
+                feedback = encryptBlock(feedback);
+                decrypted_block = block;
+                xor_bytes(decrypted_block, feedback);
+                break;
+            case CipherMode::RANDOM_DELTA: {
+                decrypted_block = decryptBlock(block);
+                xor_bytes(decrypted_block, feedback);
+                feedback = block;
+                xorDelta(feedback);
+                break;
+            }
+            default: break;
         }
+        std::copy(decrypted_block.begin(), decrypted_block.end(), output.begin() + i * block_size);
+    }
+}
+
+bool CipherContext::chunksAreIndependent(bool encrypting) const {
+    switch (m_mode) {
+        case CipherMode::ECB:
+        case CipherMode::CTR:
+            return true;
+        case CipherMode::CBC:
+        case CipherMode::CFB:
+        case CipherMode::RANDOM_DELTA:
+            // при расшифровке обратная связь берется из шифротекста, который уже прочитан
+            return !encrypting;
+        default:
+            return false;
+    }
+}
+
+void CipherContext::chunkFeedback(const byte_array& previous_chunk, byte_array& feedback) const {
+    const size_t block_size = getBlockSize();
+    if (m_mode == CipherMode::ECB || m_mode == CipherMode::CTR || previous_chunk.size() < block_size) {
+        return;
+    }
+    feedback.assign(previous_chunk.end() - block_size, previous_chunk.end());
+    if (m_mode == CipherMode::RANDOM_DELTA) {
+        xorDelta(feedback);
+    }
+}
+
+void CipherContext::xorDelta(byte_array& block) const {
+    for (size_t i = 0; i < block.size(); ++i) {
+        block[i] ^= m_delta[i];
+    }
+}
+
+std::future<void> CipherContext::encrypt(const std::vector<unsigned char>& input, std::vector<unsigned char>& output) {
+    return std::async(std::launch::async, [this, &input, &output]() {
+        std::vector<unsigned char> data = input;
+        applyPadding(data);
+        byte_array feedback = m_iv;
+        encryptBlocks(data, output, feedback, 0, true);
     });
 }
 
@@ -217,191 +362,198 @@ std::future<void> CipherContext::decrypt(const std::vector<unsigned char>& input
         if (input.size() % getBlockSize() != 0){
             std::cout << "Invalid data size." << std::endl;
         }
-        const size_t block_size = getBlockSize();
-        const size_t num_blocks = input.size() / block_size;
-        output.resize(input.size());
-
-        if (m_mode == CipherMode::ECB || m_mode == CipherMode::CTR) {
-#pragma omp parallel for
-            for (long long i = 0; i < num_blocks; ++i) {
-                std::vector<unsigned char> block(input.begin() + i * block_size, input.begin() + (i + 1) * block_size);
-                std::vector<unsigned char> decrypted_block;
-                if (m_mode == CipherMode::ECB) {
-                    decrypted_block = decryptBlock(block);
-                }
-                else {
-                    std::vector<unsigned char> counter_block = m_iv;
-                    for (long long j = 0; j < i; ++j) {
-                        for (int k = counter_block.size() - 1; k >= 0; --k) if (++counter_block[k] != 0) break; }
-                    decrypted_block = encryptBlock(counter_block); // <-- ENCRYPT
-                    xor_bytes(decrypted_block, block);
-                }
-                std::copy(decrypted_block.begin(), decrypted_block.end(), output.begin() + i * block_size);
-            }
-        }
-        else {
-            std::vector<unsigned char> feedback = m_iv;
-            for (size_t i = 0; i < num_blocks; ++i) {
-                std::vector<unsigned char> block(input.begin() + i * block_size, input.begin() + (i + 1) * block_size);
-                std::vector<unsigned char> decrypted_block;
-                switch (m_mode) {
-                    case CipherMode::CBC:
-                        decrypted_block = decryptBlock(block);
-                        xor_bytes(decrypted_block, feedback);
-                        feedback = block;
-                        break;
-                    case CipherMode::PCBC: {
-                        std::vector<unsigned char> ciphertext_copy = block;
-                        decrypted_block = decryptBlock(block);
-                        xor_bytes(decrypted_block, feedback);
-                        feedback = decrypted_block;
-                        xor_bytes(feedback, ciphertext_copy);
-                        break;
-                    }
-                    case CipherMode::CFB:
-                        decrypted_block = encryptBlock(feedback);
-                        xor_bytes(decrypted_block, block);
-                        feedback = block;
-                        break;
-                    case CipherMode::OFB:
-                        feedback = encryptBlock(feedback);
-                        decrypted_block = block;
-                        xor_bytes(decrypted_block, feedback);
-                        break;
-                    case CipherMode::RANDOM_DELTA: {
-                        const auto& delta = std::any_cast<std::vector<unsigned char>>(m_params.at("delta"));
-                        decrypted_block = decryptBlock(block);
-                        xor_bytes(decrypted_block, feedback);
-                        feedback = block;
-                        xor_bytes(feedback, delta);
-                        break;
-                    }
-                    default: break;
-                }
-                std::copy(decrypted_block.begin(), decrypted_block.end(), output.begin() + i * block_size);
-            }
-        }
+        byte_array feedback = m_iv;
+        decryptBlocks(input, output, feedback, 0, true);
         removePadding(output);
     });
 }
 
 
+namespace {
+    // Читает очередной чанк; last == true, если после него файл закончился
+    byte_array read_chunk(std::ifstream& in, size_t chunk_size, bool& last) {
+        byte_array chunk(chunk_size);
+        in.read(reinterpret_cast<char*>(chunk.data()), static_cast<std::streamsize>(chunk_size));
+        chunk.resize(static_cast<size_t>(in.gcount()));
+        last = in.peek() == std::char_traits<char>::eof();
+        return chunk;
+    }
+
+    void write_chunk(std::ofstream& out, const byte_array& chunk) {
+        out.write(reinterpret_cast<const char*>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+    }
+
+    // Запись расшифрованных чанков по порядку. При дополнении нулями хвост из нулей придерживается,
+    // пока не встретится ненулевой байт: как и decrypt(input, output), снимаются все нули в конце
+    // открытого текста, даже если они начинаются в одном из предыдущих чанков
+    class PlaintextWriter {
+    public:
+        PlaintextWriter(std::ofstream& out, bool strip_trailing_zeros)
+                : m_out(out), m_strip_trailing_zeros(strip_trailing_zeros) {}
+
+        void write(const byte_array& chunk) {
+            if (!m_strip_trailing_zeros) {
+                write_chunk(m_out, chunk);
+                return;
+            }
+            const auto last_nonzero = std::find_if(chunk.rbegin(), chunk.rend(), [](unsigned char b) { return b != 0; });
+            if (last_nonzero == chunk.rend()) {
+                m_held_zeros += chunk.size();
+                return;
+            }
+            static const char zeros[4096] = {};
+            for (; m_held_zeros > 0; m_held_zeros -= std::min(m_held_zeros, sizeof(zeros))) {
+                m_out.write(zeros, static_cast<std::streamsize>(std::min(m_held_zeros, sizeof(zeros))));
+            }
+            const size_t data_size = static_cast<size_t>(chunk.rend() - last_nonzero);
+            m_out.write(reinterpret_cast<const char*>(chunk.data()), static_cast<std::streamsize>(data_size));
+            m_held_zeros = chunk.size() - data_size;
+        }
+
+    private:
+        std::ofstream& m_out;
+        bool m_strip_trailing_zeros;
+        size_t m_held_zeros = 0; // нули в конце записанного, еще не выведенные в файл
+    };
+}
+
+// Файл обрабатывается потоково: чанки читаются по очереди, независимые чанки
+// шифруются параллельно (не больше num_threads одновременно), а результаты
+// пишутся на диск строго в исходном порядке. Формат шифротекста совпадает с encrypt(input, output).
 std::future<void> CipherContext::encrypt(const std::string& inputFile, const std::string& outputFile) {
     return std::async(std::launch::async, [this, inputFile, outputFile]() {
         std::ifstream in(inputFile, std::ios::binary);
         if (!in) {
             std::cout << "Cannot open input file " + inputFile <<std::endl;
-        }
-        byte_array original_data((std::istreambuf_iterator<char>(in)), {});
-        in.close();
-
-        applyPadding(original_data);
-
-        const int num_threads = std::max(1u, std::thread::hardware_concurrency());//количество ядер
-        const size_t total_size = original_data.size();
-        if (total_size == 0) {
             return;
         }
 
+        const size_t num_threads = std::max(1u, std::thread::hardware_concurrency());//количество ядер
         const size_t block_size = getBlockSize();
-        size_t chunk_size = (total_size / num_threads / block_size) * block_size;//чанки из целых блоков
-        if (chunk_size == 0) {
-            chunk_size = block_size; //маленькие файлы
+        const size_t chunk_size = std::max(block_size, FILE_CHUNK_SIZE / block_size * block_size);//чанки из целых блоков
+        const bool parallel = chunksAreIndependent(true);
+
+        // пустой файл - один последний чанк без данных: как и в памяти, остается только дополнение
+        bool last = false;
+        byte_array chunk = read_chunk(in, chunk_size, last);
+
+        std::ofstream out(outputFile, std::ios::binary);
+        if (!out) {
+            std::cout <<"Cannot open output file: " + outputFile << std::endl;
+            return;
         }
 
-        std::vector<std::future<byte_array>> futures;
-        size_t offset = 0;
+        std::deque<std::future<byte_array>> pending;//очередь на запись в порядке чтения
+        byte_array feedback = m_iv;
+        uint64_t first_block = 0;
 
-        while (offset < total_size) {
-            size_t current_chunk_size = std::min(chunk_size, total_size - offset);
-            if (offset + chunk_size > total_size) {//последний чанк
-                current_chunk_size = total_size - offset;
-            }
-            if (current_chunk_size == 0) {
-                break;
+        while (true) {
+            if (last) {
+                applyPadding(chunk);
             }
+            const uint64_t chunk_blocks = chunk.size() / block_size;
 
-            byte_array chunk(original_data.begin() + offset, original_data.begin() + offset + current_chunk_size);
-
-            futures.push_back(std::async(std::launch::async, [this, c = std::move(chunk)]() {
+            if (parallel) {
+                if (pending.size() >= num_threads) {
+                    write_chunk(out, pending.front().get());
+                    pending.pop_front();
+                }
+                pending.push_back(std::async(std::launch::async, [this, c = std::move(chunk), first_block]() {
+                    byte_array encrypted_chunk;
+                    byte_array unused_feedback;
+                    encryptBlocks(c, encrypted_chunk, unused_feedback, first_block, false);
+                    return encrypted_chunk;
+                }));
+            }
+            else {
                 byte_array encrypted_chunk;
-                encrypt(c, encrypted_chunk).get();
-                return encrypted_chunk;
-            }));
-
-            offset += current_chunk_size;
-        }
+                encryptBlocks(chunk, encrypted_chunk, feedback, first_block, true);
+                write_chunk(out, encrypted_chunk);
+            }
 
-        std::ofstream out(outputFile, std::ios::binary);
-        if (!out) {
-            std::cout <<"Cannot open output file: " + outputFile << std::endl;
+            first_block += chunk_blocks;
+            if (last) {
+                break;
+            }
+            chunk = read_chunk(in, chunk_size, last);
         }
 
-        for (auto& fut : futures) {
-            byte_array encrypted_chunk = fut.get();
-            out.write(reinterpret_cast<const char*>(encrypted_chunk.data()), encrypted_chunk.size());
+        for (auto& fut : pending) {
+            write_chunk(out, fut.get());
         }
     });
 }
 
+// Расшифрованные чанки сразу уходят на диск; в памяти задерживается только
+// последний чанк, из которого нужно снять дополнение (и, при дополнении нулями, нули в конце записанного).
 std::future<void> CipherContext::decrypt(const std::string& inputFile, const std::string& outputFile) {
     return std::async(std::launch::async, [this, inputFile, outputFile]() {
         std::ifstream in(inputFile, std::ios::binary);
         if (!in) {
             std::cout << "Cannot open input file: " + inputFile << std::endl;
-        }
-        byte_array encrypted_data((std::istreambuf_iterator<char>(in)), {});
-        in.close();
-
-        if (encrypted_data.empty()) {
             return;
         }
-        if (encrypted_data.size() % getBlockSize() != 0) {
-            std::cout << "Encrypted file size is not a multiple of block size." << std::endl;
-        }
 
-        const int num_threads = std::max(1u, std::thread::hardware_concurrency());
-        const size_t total_size = encrypted_data.size();
-        size_t chunk_size = (total_size / num_threads / getBlockSize()) * getBlockSize();
-        if (chunk_size == 0) {
-            chunk_size = getBlockSize();
+        const size_t num_threads = std::max(1u, std::thread::hardware_concurrency());
+        const size_t block_size = getBlockSize();
+        const size_t chunk_size = std::max(block_size, FILE_CHUNK_SIZE / block_size * block_size);
+        const bool parallel = chunksAreIndependent(false);
+
+        bool last = false;
+        byte_array chunk = read_chunk(in, chunk_size, last);
+
+        std::ofstream out(outputFile, std::ios::binary);
+        if (!out) {
+            std::cout <<"Cannot open output file: " + outputFile << std::endl;
+            return;
         }
 
-        std::vector<std::future<byte_array>> futures;
-        size_t offset = 0;
+        PlaintextWriter writer(out, m_padding == PaddingScheme::Zeros);
+        std::deque<std::future<byte_array>> pending;
+        byte_array feedback = m_iv;
+        uint64_t first_block = 0;
 
-        while (offset < total_size) {
-            size_t current_chunk_size = std::min(chunk_size, total_size - offset);
-            if (offset + chunk_size > total_size) {
-                current_chunk_size = total_size - offset;
+        while (true) {
+            if (last && chunk.size() % block_size != 0) {
+                std::cout << "Encrypted file size is not a multiple of block size." << std::endl;
             }
-            if (current_chunk_size == 0) {
-                break;
-            }
-
-            byte_array chunk(encrypted_data.begin() + offset, encrypted_data.begin() + offset + current_chunk_size);
+            const uint64_t chunk_blocks = chunk.size() / block_size;
 
-            futures.push_back(std::async(std::launch::async, [this, c = std::move(chunk)]() {
+            if (parallel) {
+                if (pending.size() >= num_threads) {
+                    writer.write(pending.front().get());
+                    pending.pop_front();
+                }
+                byte_array next_feedback = feedback;
+                chunkFeedback(chunk, next_feedback);
+                pending.push_back(std::async(std::launch::async, [this, c = std::move(chunk), f = std::move(feedback), first_block, last]() mutable {
+                    byte_array decrypted_chunk;
+                    decryptBlocks(c, decrypted_chunk, f, first_block, false);
+                    if (last) {
+                        removePadding(decrypted_chunk);
+                    }
+                    return decrypted_chunk;
+                }));
+                feedback = std::move(next_feedback);
+            }
+            else {
                 byte_array decrypted_chunk;
-                decrypt(c, decrypted_chunk).get();
-                return decrypted_chunk;
-            }));
-
-            offset += current_chunk_size;
-        }
+                decryptBlocks(chunk, decrypted_chunk, feedback, first_block, true);
+                if (last) {
+                    removePadding(decrypted_chunk);
+                }
+                writer.write(decrypted_chunk);
+            }
 
-        byte_array decrypted_data;
-        for (auto& fut : futures) {
-            byte_array decrypted_chunk = fut.get();
-            decrypted_data.insert(decrypted_data.end(), decrypted_chunk.begin(), decrypted_chunk.end());
+            first_block += chunk_blocks;
+            if (last) {
+                break;
+            }
+            chunk = read_chunk(in, chunk_size, last);
         }
 
-        removePadding(decrypted_data);
-
-        std::ofstream out(outputFile, std::ios::binary);
-        if (!out) {
-            std::cout <<"Cannot open output file: " + outputFile << std::endl;
+        for (auto& fut : pending) {
+            writer.write(fut.get());
         }
-        out.write(reinterpret_cast<const char*>(decrypted_data.data()), decrypted_data.size());
     });
-}
\ No newline at end of file
+}
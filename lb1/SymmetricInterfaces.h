@@ -11,7 +11,11 @@
 #include <future>
 #include <map>
 #include <any>
+#include <variant>
+#include <array>
 #include <fstream>
+#include <cstdint>
+#include "CpuDispatch.h"
 
 #ifdef _OPENMP
 #include <omp.h>
@@ -25,9 +29,22 @@ inline void xor_bytes(std::vector<unsigned char>& a, const std::vector<unsigned
     if (a.size() != b.size()) {
         throw std::invalid_argument("xor_bytes: vectors must have the same size: a=" + std::to_string(a.size()) + " b=" + std::to_string(b.size()));
     }
+    if (a.size() >= 32) {
+        CpuDispatch::kernels().xor_bytes(a.data(), b.data(), a.size());
+        return;
+    }
     for (size_t i = 0; i < a.size(); ++i) a[i] ^= b[i];
 }
 
+// counter += value (big-endian), для CTR
+inline void add_to_counter(std::vector<unsigned char>& counter, uint64_t value) {
+    for (size_t k = counter.size(); k-- > 0 && value != 0;) {
+        uint64_t sum = counter[k] + (value & 0xFF);
+        counter[k] = static_cast<unsigned char>(sum);
+        value = (value >> 8) + (sum >> 8);
+    }
+}
+
 
 //2.1
 class IKeyExpander{
@@ -64,6 +81,13 @@ enum class CipherMode{
     RANDOM_DELTA
 };
 
+// Типизированные параметры режимов; проверяются один раз в конструкторе CipherContext
+struct RandomDeltaParams {
+    byte_array delta;
+};
+
+using ModeParams = std::variant<std::monostate, RandomDeltaParams>;
+
 enum class PaddingScheme{
     Zeros,
     ANSI_X923,
@@ -73,17 +97,36 @@ enum class PaddingScheme{
 
 
 class CipherContext : public ISymmetricCipher {
+public:
+    static constexpr size_t MAX_BLOCK_SIZE = 16; // наибольший блок среди алгоритмов (DEAL)
+
 private:
     std::unique_ptr<ISymmetricCipher> m_algorithm;
     CipherMode m_mode;
     PaddingScheme m_padding;
     byte_array m_iv;
-    ExtraParams m_params;
+    // delta режима RANDOM_DELTA: первые getBlockSize() байт, без выделения памяти
+    std::array<unsigned char, MAX_BLOCK_SIZE> m_delta{};
+
+    static constexpr size_t FILE_CHUNK_SIZE = 1 << 20;
 
     void applyPadding(byte_array& data);
     void removePadding(byte_array& data);
 
+    // parallel_blocks - раздавать блоки ECB/CTR команде OpenMP; false внутри задач по чанкам файла,
+    // которые уже заняли по ядру каждая (иначе N задач запускали бы по N потоков)
+    void encryptBlocks(const byte_array& data, byte_array& output, byte_array& feedback, uint64_t first_block,
+                       bool parallel_blocks);
+    void decryptBlocks(const byte_array& input, byte_array& output, byte_array& feedback, uint64_t first_block,
+                       bool parallel_blocks);
+    bool chunksAreIndependent(bool encrypting) const;
+    void chunkFeedback(const byte_array& previous_chunk, byte_array& feedback) const;
+    void xorDelta(byte_array& block) const;
+    static ModeParams toModeParams(CipherMode mode, const ExtraParams& params);
+
 public:
+    // std::invalid_argument: нет IV или он не размером с блок для режима с IV, нет delta или она
+    // не размером с блок для RANDOM_DELTA
     CipherContext(
             std::unique_ptr<ISymmetricCipher> algorithm,
             const byte_array& key,
@@ -92,6 +135,14 @@ public:
             std::optional<byte_array> iv = std::nullopt,
             ExtraParams params = {}
     );
+    CipherContext(
+            std::unique_ptr<ISymmetricCipher> algorithm,
+            const byte_array& key,
+            CipherMode mode,
+            PaddingScheme padding,
+            std::optional<byte_array> iv,
+            ModeParams params
+    );
 
     void setKey(const byte_array& key) override;
     byte_array encryptBlock(const byte_array& block) override;
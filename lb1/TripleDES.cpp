@@ -0,0 +1,80 @@
+#include "TripleDES.h"
+#include <algorithm>
+#include <iostream>
+
+namespace DES_Implementation {
+    TripleDES::TripleDES(TripleDES_Variant variant) : m_variant(variant) {}
+
+    void TripleDES::setKey(const byte_array& key) {
+        const size_t expected_size = (m_variant == TripleDES_Variant::EDE2) ? 16 : 24;
+        if (key.size() != expected_size) {
+            throw std::invalid_argument("3DES key must be " + std::to_string(expected_size) + " bytes, got " + std::to_string(key.size()));
+        }
+
+        DESKeyExpander expander;
+        std::array<round_keys_array, 3> stage_keys;
+        for (size_t stage = 0; stage < 3; ++stage) {
+            size_t part = (m_variant == TripleDES_Variant::EDE2 && stage == 2) ? 0 : stage;
+            byte_array des_key(key.begin() + part * 8, key.begin() + (part + 1) * 8);
+            stage_keys[stage] = expander.generateRoundKeys(des_key);
+        }
+
+        // E(K1) -> D(K2) -> E(K3): ключи второй ступени идут в обратном порядке
+        std::reverse(stage_keys[1].begin(), stage_keys[1].end());
+        for (size_t stage = 0; stage < 3; ++stage) {
+            for (size_t round = 0; round < 16; ++round) {
+                const byte_array& k = stage_keys[stage][round];
+                m_encryption_keys[stage * 16 + round] = bytes_to_word(k.data(), k.size());
+            }
+        }
+        // расшифрование - те же 48 раундов с ключами в обратном порядке
+        std::reverse_copy(m_encryption_keys.begin(), m_encryption_keys.end(), m_decryption_keys.begin());
+        m_key_set = true;
+    }
+
+    uint64_t TripleDES::processBlock(uint64_t block, const std::array<uint64_t, 48>& round_keys) const {
+        block = initial_permutation(block);
+        uint32_t left = static_cast<uint32_t>(block >> 32);
+        uint32_t right = static_cast<uint32_t>(block);
+
+        for (size_t stage = 0; stage < 3; ++stage) {
+            for (size_t round = 0; round < 16; ++round) {
+                uint32_t old_left = left;
+                left = right;
+                right = DESRoundFunction::applyWord(right, round_keys[stage * 16 + round]) ^ old_left;
+            }
+            // выход ступени DES - R16||L16; FP и следующий IP сокращаются, остается только перестановка половин
+            std::swap(left, right);
+        }
+
+        return final_permutation((static_cast<uint64_t>(left) << 32) | right);
+    }
+
+    byte_array TripleDES::encryptBlock(const byte_array& block) {
+        if (!m_key_set) {
+            throw std::logic_error("3DES key is not set.");
+        }
+        if (block.size() != 8) {
+            throw std::invalid_argument("3DES block must be 8 bytes.");
+        }
+        byte_array result(8);
+        word_to_bytes(processBlock(bytes_to_word(block.data(), 8), m_encryption_keys), result.data(), result.size());
+        return result;
+    }
+
+    byte_array TripleDES::decryptBlock(const byte_array& block) {
+        if (!m_key_set) {
+            throw std::logic_error("3DES key is not set.");
+        }
+        if (block.size() != 8) {
+            throw std::invalid_argument("3DES block must be 8 bytes.");
+        }
+        byte_array result(8);
+        word_to_bytes(processBlock(bytes_to_word(block.data(), 8), m_decryption_keys), result.data(), result.size());
+        return result;
+    }
+
+    size_t TripleDES::getBlockSize() const {
+        return 8;
+    }
+}
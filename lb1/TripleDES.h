@@ -0,0 +1,34 @@
+#ifndef CRYPTOGRAPHY_TRIPLEDES_H
+#define CRYPTOGRAPHY_TRIPLEDES_H
+
+#include "DES.h"
+#include <array>
+
+namespace DES_Implementation {
+    enum class TripleDES_Variant {
+        EDE2, // K1, K2, K1 - ключ 16 байт
+        EDE3  // K1, K2, K3 - ключ 24 байта
+    };
+
+    // 3DES (EDE) на ключевом расписании и функции раунда DES.
+    // Внутренние пары FP/IP между ступенями взаимно сокращаются, поэтому блок проходит
+    // IP один раз, затем 48 раундов подряд и FP один раз.
+    class TripleDES : public ISymmetricCipher {
+    public:
+        TripleDES(TripleDES_Variant variant = TripleDES_Variant::EDE3);
+        void setKey(const std::vector<unsigned char>& key) override;
+        std::vector<unsigned char> encryptBlock(const std::vector<unsigned char>& block) override;
+        std::vector<unsigned char> decryptBlock(const std::vector<unsigned char>& block) override;
+        size_t getBlockSize() const override;
+
+    private:
+        uint64_t processBlock(uint64_t block, const std::array<uint64_t, 48>& round_keys) const;
+
+        TripleDES_Variant m_variant;
+        std::array<uint64_t, 48> m_encryption_keys{};
+        std::array<uint64_t, 48> m_decryption_keys{};
+        bool m_key_set = false;
+    };
+}
+
+#endif //CRYPTOGRAPHY_TRIPLEDES_H
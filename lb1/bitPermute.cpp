@@ -3,8 +3,10 @@
 //
 
 #include "bitPermute.h"
+#include "CpuDispatch.h"
 #include<iostream>
 #include <vector>
+#include <stdexcept>
 
 
 std::vector<unsigned char> permute(
@@ -56,3 +58,178 @@ std::vector<unsigned char> permute(
 
     return output;
 }
+
+
+uint64_t bytes_to_word(const unsigned char* data, size_t size) {
+    uint64_t word = 0;
+    for (size_t i = 0; i < size; ++i) {
+        word = (word << 8) | data[i];
+    }
+    return word;
+}
+
+void word_to_bytes(uint64_t word, unsigned char* data, size_t size) {
+    for (size_t i = size; i-- > 0;) {
+        data[i] = static_cast<unsigned char>(word);
+        word >>= 8;
+    }
+}
+
+namespace {
+    uint128 bytes_to_word128(const unsigned char* data, size_t size) {
+        uint128 word = 0;
+        for (size_t i = 0; i < size; ++i) {
+            word = (word << 8) | data[i];
+        }
+        return word;
+    }
+
+    void word128_to_bytes(uint128 word, unsigned char* data, size_t size) {
+        for (size_t i = size; i-- > 0;) {
+            data[i] = static_cast<unsigned char>(word);
+            word >>= 8;
+        }
+    }
+}
+
+CompiledPermutation::CompiledPermutation(const std::vector<int>& p_block, BitDir direction, BitBase base, size_t input_bytes)
+        : CompiledPermutation(p_block, direction, base, input_bytes, std::nullopt)
+{
+}
+
+CompiledPermutation::CompiledPermutation(const std::vector<int>& p_block, BitDir direction, BitBase base, size_t input_bytes,
+                                         Strategy strategy)
+        : CompiledPermutation(p_block, direction, base, input_bytes, std::optional<Strategy>(strategy))
+{
+}
+
+CompiledPermutation::CompiledPermutation(const std::vector<int>& p_block, BitDir direction, BitBase base, size_t input_bytes,
+                                         std::optional<Strategy> forced)
+        : m_output_bits(p_block.size()),
+          m_strategy(Strategy::BYTE_LUT)
+{
+    if (p_block.empty() || m_output_bits % 8 != 0) {
+        throw std::invalid_argument("P-block size (output bit count) must be a non-zero multiple of 8.");
+    }
+
+    std::vector<int> sources(p_block);
+    int max_index = 0;
+    for (int& source : sources) {
+        if (base == BitBase::ONE_BASE) {
+            source--;
+        }
+        if (source < 0) {
+            throw std::invalid_argument("P-block index is out of input data range.");
+        }
+        max_index = std::max(max_index, source);
+    }
+    if (input_bytes == 0) {
+        input_bytes = max_index / 8 + 1;
+    }
+    m_input_bits = input_bytes * 8;
+    if (static_cast<size_t>(max_index) >= m_input_bits) {
+        throw std::invalid_argument("P-block index is out of input data range.");
+    }
+    if (m_input_bits > 128 || m_output_bits > 128) {
+        throw std::invalid_argument("Compiled permutations support at most 128-bit words.");
+    }
+
+    // позиции в словах, 0 - младший бит
+    std::vector<int> source_pos(m_output_bits);
+    std::vector<int> target_pos(m_output_bits);
+    for (size_t i = 0; i < m_output_bits; ++i) {
+        int byte_idx = sources[i] / 8;
+        int bit_in_byte = sources[i] % 8;
+        int shift = (direction == BitDir::BIG_END) ? (7 - bit_in_byte) : bit_in_byte;
+        source_pos[i] = static_cast<int>(m_input_bits) - 8 * (byte_idx + 1) + shift;
+        target_pos[i] = static_cast<int>(m_output_bits - 1 - i);
+    }
+
+    // Жадно разбиваем биты на цепочки, возрастающие и по источнику, и по приемнику:
+    // каждая цепочка переносится одной парой pext/pdep.
+    const bool fits_word = m_input_bits <= 64 && m_output_bits <= 64;
+    if (forced == Strategy::PEXT_GROUPS && !fits_word) {
+        throw std::invalid_argument("PEXT_GROUPS supports at most 64-bit words.");
+    }
+    if (forced == Strategy::PEXT_GROUPS || (!forced && CpuDispatch::kernels().bmi2 && fits_word)) {
+        std::vector<size_t> order(m_output_bits);
+        for (size_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return source_pos[a] != source_pos[b] ? source_pos[a] < source_pos[b] : target_pos[a] < target_pos[b];
+        });
+        std::vector<int> chain_last_source;
+        std::vector<int> chain_last_target;
+        std::vector<uint64_t> source_masks;
+        std::vector<uint64_t> target_masks;
+        for (size_t idx : order) {
+            size_t chain = 0;
+            while (chain < chain_last_source.size()
+                   && (chain_last_source[chain] >= source_pos[idx] || chain_last_target[chain] >= target_pos[idx])) {
+                ++chain;
+            }
+            if (chain == chain_last_source.size()) {
+                chain_last_source.push_back(-1);
+                chain_last_target.push_back(-1);
+                source_masks.push_back(0);
+                target_masks.push_back(0);
+            }
+            chain_last_source[chain] = source_pos[idx];
+            chain_last_target[chain] = target_pos[idx];
+            source_masks[chain] |= 1ULL << source_pos[idx];
+            target_masks[chain] |= 1ULL << target_pos[idx];
+        }
+        // таблица стоит одну загрузку на входной байт, группа - две инструкции
+        if (forced == Strategy::PEXT_GROUPS || source_masks.size() <= input_bytes) {
+            m_strategy = Strategy::PEXT_GROUPS;
+            m_source_masks = std::move(source_masks);
+            m_target_masks = std::move(target_masks);
+            return;
+        }
+    }
+
+    m_byte_lut.assign(input_bytes * 256, 0);
+    for (size_t i = 0; i < m_output_bits; ++i) {
+        size_t byte_from_low = source_pos[i] / 8;
+        int bit = source_pos[i] % 8;
+        uint128* table = &m_byte_lut[byte_from_low * 256];
+        for (int value = 0; value < 256; ++value) {
+            if ((value >> bit) & 1) {
+                table[value] |= static_cast<uint128>(1) << target_pos[i];
+            }
+        }
+    }
+}
+
+uint64_t CompiledPermutation::apply(uint64_t input) const {
+    if (m_strategy == Strategy::PEXT_GROUPS) {
+        return CpuDispatch::kernels().gather_scatter_bits(input, m_source_masks.data(), m_target_masks.data(), m_source_masks.size());
+    }
+    return static_cast<uint64_t>(apply128(input));
+}
+
+uint128 CompiledPermutation::apply128(uint128 input) const {
+    if (m_strategy == Strategy::PEXT_GROUPS) {
+        return apply(static_cast<uint64_t>(input));
+    }
+    uint128 result = 0;
+    const size_t input_bytes = m_input_bits / 8;
+    for (size_t b = 0; b < input_bytes; ++b) {
+        result |= m_byte_lut[b * 256 + static_cast<unsigned char>(input >> (8 * b))];
+    }
+    return result;
+}
+
+std::vector<unsigned char> CompiledPermutation::apply(const std::vector<unsigned char>& input) const {
+    if (input.size() * 8 != m_input_bits) {
+        throw std::invalid_argument("Input size does not match the compiled P-block.");
+    }
+    std::vector<unsigned char> output(m_output_bits / 8);
+    if (m_input_bits <= 64 && m_output_bits <= 64) {
+        word_to_bytes(apply(bytes_to_word(input.data(), input.size())), output.data(), output.size());
+    } else {
+        word128_to_bytes(apply128(bytes_to_word128(input.data(), input.size())), output.data(), output.size());
+    }
+    return output;
+}
@@ -8,6 +8,8 @@
 #include <vector>
 #include <string>
 #include<algorithm>
+#include <cstdint>
+#include <optional>
 
 
 enum class BitDir {
@@ -27,6 +29,49 @@ std::vector<unsigned char> permute(
         BitBase base
 );
 
+using uint128 = unsigned __int128;
+
+// P-блок, "скомпилированный" один раз под конкретную таблицу.
+// Вход и выход упаковываются в слово big-endian: байт 0 - старший, биты выровнены к младшему краю.
+// Применение не выделяет память; стратегия выбирается в конструкторе:
+//   PEXT_GROUPS - группы pext/pdep (только при BMI2 и словах до 64 бит),
+//   BYTE_LUT    - по таблице из 256 масок на каждый входной байт.
+class CompiledPermutation {
+public:
+    enum class Strategy {
+        PEXT_GROUPS,
+        BYTE_LUT
+    };
+
+    // input_bytes == 0 - размер входа определяется по наибольшему индексу в p_block
+    CompiledPermutation(const std::vector<int>& p_block, BitDir direction, BitBase base, size_t input_bytes = 0);
+    // Принудительная стратегия (для тестов и замеров); PEXT_GROUPS без BMI2 идет через
+    // скалярные pext/pdep, для слов длиннее 64 бит - std::invalid_argument
+    CompiledPermutation(const std::vector<int>& p_block, BitDir direction, BitBase base, size_t input_bytes, Strategy strategy);
+
+    uint64_t apply(uint64_t input) const;
+    uint128 apply128(uint128 input) const;
+    std::vector<unsigned char> apply(const std::vector<unsigned char>& input) const;
+
+    size_t inputBits() const { return m_input_bits; }
+    size_t outputBits() const { return m_output_bits; }
+    Strategy strategy() const { return m_strategy; }
+
+private:
+    CompiledPermutation(const std::vector<int>& p_block, BitDir direction, BitBase base, size_t input_bytes,
+                        std::optional<Strategy> forced);
+
+    size_t m_input_bits;
+    size_t m_output_bits;
+    Strategy m_strategy;
+    std::vector<uint64_t> m_source_masks;
+    std::vector<uint64_t> m_target_masks;
+    std::vector<uint128> m_byte_lut;
+};
+
+uint64_t bytes_to_word(const unsigned char* data, size_t size);
+void word_to_bytes(uint64_t word, unsigned char* data, size_t size);
+
 
 void print_binary(const std::string& label, const std::vector<unsigned char>& data);
 
@@ -0,0 +1,159 @@
+#include <iostream>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include "CpuDispatch.h"
+#include "bitPermute.h"
+
+// Запускается отдельным процессом на каждый уровень: ядра выбираются один раз за процесс,
+// уровень задается переменной окружения CRYPTO_CPU_TIER (см. lb1/CMakeLists.txt).
+
+using namespace CpuDispatch;
+
+namespace {
+
+    bool tier_supported(CpuTier tier) {
+        const CpuFeatures& features = cpu_features();
+        switch (tier) {
+            case CpuTier::AVX512: return features.avx512;
+            case CpuTier::AVX2: return features.avx2;
+            case CpuTier::SSSE3: return features.ssse3;
+            case CpuTier::SSE2: return features.sse2;
+            case CpuTier::SCALAR:
+            default: return true;
+        }
+    }
+
+    uint64_t pext_reference(uint64_t input, uint64_t mask) {
+        uint64_t result = 0;
+        for (uint64_t bit = 1; mask != 0; mask &= mask - 1, bit <<= 1) {
+            if (input & mask & (~mask + 1)) result |= bit;
+        }
+        return result;
+    }
+
+    uint64_t pdep_reference(uint64_t input, uint64_t mask) {
+        uint64_t result = 0;
+        for (uint64_t bit = 1; mask != 0; mask &= mask - 1, bit <<= 1) {
+            if (input & bit) result |= mask & (~mask + 1);
+        }
+        return result;
+    }
+
+    // Все длины до нескольких векторных регистров и невыровненные смещения: проверяются и основной
+    // цикл, и хвост каждого ядра
+    bool test_xor_bytes(std::mt19937_64& rng) {
+        const size_t max_size = 300;
+        std::vector<unsigned char> a(max_size + 64), b(max_size + 64);
+        for (size_t offset = 0; offset < 64; offset += 7) {
+            for (size_t size = 0; size <= max_size; ++size) {
+                for (auto& byte : a) byte = static_cast<unsigned char>(rng());
+                for (auto& byte : b) byte = static_cast<unsigned char>(rng());
+                std::vector<unsigned char> expected = a;
+                for (size_t i = 0; i < size; ++i) {
+                    expected[offset + i] ^= b[offset + i];
+                }
+                kernels().xor_bytes(a.data() + offset, b.data() + offset, size);
+                if (a != expected) {
+                    std::cout << "Mismatch: xor_bytes, size " << size << ", offset " << offset << std::endl;
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    bool test_gather_scatter_bits(std::mt19937_64& rng) {
+        for (int iteration = 0; iteration < 1000; ++iteration) {
+            const size_t groups = 1 + rng() % 8;
+            std::vector<uint64_t> source(groups), target(groups);
+            uint64_t expected = 0;
+            const uint64_t input = rng();
+            for (size_t g = 0; g < groups; ++g) {
+                source[g] = rng() & rng();
+                target[g] = rng();
+                expected |= pdep_reference(pext_reference(input, source[g]), target[g]);
+            }
+            const uint64_t actual = kernels().gather_scatter_bits(input, source.data(), target.data(), groups);
+            if (actual != expected) {
+                std::cout << "Mismatch: gather_scatter_bits, " << groups << " groups" << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Сдвиг на байт - две цепочки pext/pdep: с BMI2 выбираются группы, без BMI2 (уровень ниже avx2
+    // или микрокодный pext) - обязательно таблица. Обе стратегии должны совпадать с принудительными группами
+    bool test_permutation_strategy(std::mt19937_64& rng) {
+        std::vector<int> rotation(64), shuffled(64);
+        for (size_t i = 0; i < rotation.size(); ++i) {
+            rotation[i] = static_cast<int>((i + 8) % 64);
+            shuffled[i] = static_cast<int>(i);
+        }
+        std::shuffle(shuffled.begin(), shuffled.end(), rng);
+        for (const std::vector<int>* p_block : {&rotation, &shuffled}) {
+            const CompiledPermutation selected(*p_block, BitDir::BIG_END, BitBase::ZERO_BASE);
+            const CompiledPermutation groups(*p_block, BitDir::BIG_END, BitBase::ZERO_BASE, 0,
+                                             CompiledPermutation::Strategy::PEXT_GROUPS);
+            const bool lut = selected.strategy() == CompiledPermutation::Strategy::BYTE_LUT;
+            std::cout << (p_block == &rotation ? "Rotation" : "Shuffle") << " permutation strategy: "
+                      << (lut ? "byte_lut" : "pext_groups") << std::endl;
+            if (!kernels().bmi2 && !lut) {
+                std::cout << "Mismatch: CompiledPermutation uses pext groups without BMI2 kernels" << std::endl;
+                return false;
+            }
+            if (kernels().bmi2 && p_block == &rotation && lut) {
+                std::cout << "Mismatch: CompiledPermutation ignores BMI2 kernels" << std::endl;
+                return false;
+            }
+            for (int iteration = 0; iteration < 1000; ++iteration) {
+                const uint64_t input = rng();
+                if (selected.apply(input) != groups.apply(input)) {
+                    std::cout << "Mismatch: CompiledPermutation strategies disagree" << std::endl;
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+}
+
+int main() {
+    const char* value = std::getenv("CRYPTO_CPU_TIER");
+    const std::string requested = value ? value : "";
+    const SymmetricKernels& k = kernels();
+
+    std::cout << "CRYPTO_CPU_TIER=" << requested << ", selected tier: " << tier_name(k.tier)
+              << ", bmi2: " << (k.bmi2 ? "yes" : "no")
+              << (cpu_features().slow_pext ? " (microcoded pext)" : "") << std::endl;
+
+    for (CpuTier tier : {CpuTier::SCALAR, CpuTier::SSE2, CpuTier::SSSE3, CpuTier::AVX2, CpuTier::AVX512}) {
+        if (requested != tier_name(tier)) {
+            continue;
+        }
+        if (!tier_supported(tier)) {
+            std::cout << "Tier " << requested << " is not supported by this CPU, checking " << tier_name(k.tier) << " instead" << std::endl;
+        } else if (k.tier != tier) {
+            std::cout << "Mismatch: requested tier " << requested << ", selected " << tier_name(k.tier) << std::endl;
+            return 1;
+        }
+    }
+    if (k.tier < CpuTier::AVX2 && k.bmi2) {
+        std::cout << "Mismatch: BMI2 kernels selected below avx2" << std::endl;
+        return 1;
+    }
+    if (cpu_features().slow_pext && k.bmi2) {
+        std::cout << "Mismatch: BMI2 kernels selected with microcoded pext" << std::endl;
+        return 1;
+    }
+
+    std::mt19937_64 rng(0xC0FFEE);
+    if (!test_xor_bytes(rng) || !test_gather_scatter_bits(rng) || !test_permutation_strategy(rng)) {
+        return 1;
+    }
+    std::cout << "Kernels match scalar reference" << std::endl;
+    return 0;
+}
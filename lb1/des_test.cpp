@@ -4,7 +4,9 @@
 #include <vector>
 #include <memory>
 #include <chrono>
+#include <random>
 #include "DES.h"
+#include "TripleDES.h"
 
 using namespace DES_Implementation;
 namespace fs = std::filesystem;
@@ -23,7 +25,7 @@ bool compare_buffers(const std::vector<unsigned char>& a, const std::vector<unsi
     return a == b;
 }
 
-void test_mode(const std::string& file, CipherMode mode, PaddingScheme padding, ExtraParams params = {}) {
+void test_mode(const std::string& file, CipherMode mode, PaddingScheme padding, ModeParams params = {}) {
     std::cout << "\nTesting file: " << file << " | mode: ";
     switch (mode) {
         case CipherMode::ECB: std::cout << "ECB"; break;
@@ -84,8 +86,171 @@ void test_mode(const std::string& file, CipherMode mode, PaddingScheme padding,
         std::cout << "Mismatch after decrypt (file mode)\n";
 }
 
+// Эталоны с различными ключами: EDE3 - пример из NIST SP 800-67, EDE2 (K3 = K1) - по OpenSSL des-ede
+void test_triple_des_vectors() {
+    std::cout << "\nTesting 3DES known-answer vectors" << std::endl;
+    const byte_array k1 = { 0x01,0x23,0x45,0x67,0x89,0xAB,0xCD,0xEF };
+    const byte_array k2 = { 0x23,0x45,0x67,0x89,0xAB,0xCD,0xEF,0x01 };
+    const byte_array k3 = { 0x45,0x67,0x89,0xAB,0xCD,0xEF,0x01,0x23 };
+    const byte_array plaintext = { 0x54,0x68,0x65,0x20,0x71,0x75,0x66,0x63 }; // "The qufc"
+
+    struct Vector {
+        const char* name;
+        TripleDES_Variant variant;
+        std::vector<byte_array> keys;
+        byte_array ciphertext;
+    };
+    const std::vector<Vector> vectors = {
+            {"EDE2", TripleDES_Variant::EDE2, {k1, k2}, { 0xC4,0x48,0x62,0xF7,0x0C,0xF2,0xFB,0xDC }},
+            {"EDE3", TripleDES_Variant::EDE3, {k1, k2, k3}, { 0xA8,0x26,0xFD,0x8C,0xE5,0x3B,0x85,0x5F }}
+    };
+    // Классический пример DES (ключ 133457799BBCDFF1): ловит ошибки расписания ключей отдельно от EDE
+    DES single;
+    single.setKey({ 0x13,0x34,0x57,0x79,0x9B,0xBC,0xDF,0xF1 });
+    if (single.encryptBlock({ 0x01,0x23,0x45,0x67,0x89,0xAB,0xCD,0xEF }) == byte_array{ 0x85,0xE8,0x13,0x54,0x0F,0x0A,0xB4,0x05 })
+        std::cout << "DES known-answer vector OK\n";
+    else
+        std::cout << "Mismatch: DES known-answer vector\n";
+
+    for (const auto& vector : vectors) {
+        byte_array key;
+        for (const auto& part : vector.keys) {
+            key.insert(key.end(), part.begin(), part.end());
+        }
+        TripleDES cipher(vector.variant);
+        cipher.setKey(key);
+        if (cipher.encryptBlock(plaintext) == vector.ciphertext && cipher.decryptBlock(vector.ciphertext) == plaintext)
+            std::cout << "3DES " << vector.name << " known-answer vector OK\n";
+        else
+            std::cout << "Mismatch: 3DES " << vector.name << " known-answer vector\n";
+    }
+}
+
+void test_triple_des(const std::string& file) {
+    std::cout << "\nTesting 3DES on file: " << file << std::endl;
+    byte_array k1 = { 0x13,0x34,0x57,0x79,0x9B,0xBC,0xDF,0xF1 };
+    byte_array k2 = { 0x01,0x23,0x45,0x67,0x89,0xAB,0xCD,0xEF };
+    byte_array k3 = { 0xFE,0xDC,0xBA,0x98,0x76,0x54,0x32,0x10 };
+    byte_array key_ede3 = k1;
+    key_ede3.insert(key_ede3.end(), k2.begin(), k2.end());
+    key_ede3.insert(key_ede3.end(), k3.begin(), k3.end());
+
+    TripleDES same_keys;
+    byte_array triple_k1 = k1;
+    triple_k1.insert(triple_k1.end(), k1.begin(), k1.end());
+    triple_k1.insert(triple_k1.end(), k1.begin(), k1.end());
+    same_keys.setKey(triple_k1);
+    DES single;
+    single.setKey(k1);
+    byte_array block = { 0x01,0x23,0x45,0x67,0x89,0xAB,0xCD,0xEF };
+    if (same_keys.encryptBlock(block) == single.encryptBlock(block))
+        std::cout << "3DES with K1=K2=K3 matches DES\n";
+    else
+        std::cout << "Mismatch: 3DES with K1=K2=K3 differs from DES\n";
+
+    std::vector<unsigned char> original = read_file(file);
+    byte_array iv = { 0x12,0x34,0x56,0x78,0x90,0xAB,0xCD,0xEF };
+    CipherContext ctx(std::make_unique<TripleDES>(), key_ede3, CipherMode::CBC, PaddingScheme::PKCS7, iv);
+    std::vector<unsigned char> encrypted;
+    ctx.encrypt(original, encrypted).get();
+    std::vector<unsigned char> decrypted;
+    ctx.decrypt(encrypted, decrypted).get();
+    if (compare_buffers(original, decrypted))
+        std::cout << "3DES in-memory encryption/decryption OK\n";
+    else
+        std::cout << "Mismatch after 3DES decrypt (in-memory)\n";
+}
+
+// Обе стратегии CompiledPermutation должны совпадать с эталонной permute() на всех таблицах DES
+void test_compiled_permutations() {
+    std::cout << "\nTesting compiled DES permutations" << std::endl;
+    struct Table {
+        const char* name;
+        const std::vector<int>& p_block;
+        size_t input_bytes;
+    };
+    const std::vector<Table> tables = {
+            {"IP", DES_Tables::IP, 8},
+            {"FP", DES_Tables::FP, 8},
+            {"E", DES_Tables::E, 4},
+            {"P", DES_Tables::P, 4},
+            {"PC1", DES_Tables::PC1, 8},
+            {"PC2", DES_Tables::PC2, 7}
+    };
+    const std::vector<std::pair<const char*, CompiledPermutation::Strategy>> strategies = {
+            {"PEXT_GROUPS", CompiledPermutation::Strategy::PEXT_GROUPS},
+            {"BYTE_LUT", CompiledPermutation::Strategy::BYTE_LUT}
+    };
+    std::mt19937 rng(46);
+    for (const auto& table : tables) {
+        for (const auto& strategy : strategies) {
+            CompiledPermutation compiled(table.p_block, BitDir::BIG_END, BitBase::ONE_BASE, table.input_bytes, strategy.second);
+            bool ok = compiled.strategy() == strategy.second;
+            for (int i = 0; i < 1000 && ok; ++i) {
+                byte_array input(table.input_bytes);
+                for (auto& byte : input) byte = static_cast<unsigned char>(rng());
+                ok = compiled.apply(input) == permute(input, table.p_block, BitDir::BIG_END, BitBase::ONE_BASE);
+            }
+            if (ok)
+                std::cout << table.name << " (" << strategy.first << ") matches permute()\n";
+            else
+                std::cout << "Mismatch: " << table.name << " (" << strategy.first << ") differs from permute()\n";
+        }
+    }
+}
+
+void write_file(const std::string& path, const byte_array& data) {
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+}
+
+// Файловый путь должен давать то же, что и шифрование в памяти: пустой файл с PKCS7 - один блок
+// дополнения, а при дополнении нулями снимается весь хвост из нулей, даже через границу чанков (1 МБ)
+void test_file_edge_cases() {
+    std::cout << "\nTesting file edge cases" << std::endl;
+    byte_array key = { 0x13,0x34,0x57,0x79,0x9B,0xBC,0xDF,0xF1 };
+    byte_array iv  = { 0x12,0x34,0x56,0x78,0x90,0xAB,0xCD,0xEF };
+    const std::string plain = "edge_case.bin";
+    const std::string encrypted = "edge_case.bin.enc";
+    const std::string decrypted = "edge_case.bin.dec";
+
+    CipherContext pkcs7(std::make_unique<DES>(), key, CipherMode::CBC, PaddingScheme::PKCS7, iv);
+    write_file(plain, {});
+    pkcs7.encrypt(plain, encrypted).get();
+    byte_array expected;
+    pkcs7.encrypt(byte_array{}, expected).get();
+    pkcs7.decrypt(encrypted, decrypted).get();
+    if (read_file(encrypted) == expected && expected.size() == 8 && fs::exists(decrypted) && read_file(decrypted).empty())
+        std::cout << "Empty file encrypts to one padding block OK\n";
+    else
+        std::cout << "Mismatch: empty file encryption differs from in-memory\n";
+
+    const size_t chunk = 1 << 20;
+    byte_array data(chunk + 4, 0);
+    for (size_t i = 0; i < chunk - 16; ++i) data[i] = static_cast<unsigned char>(i % 251 + 1);
+    for (CipherMode mode : { CipherMode::CBC, CipherMode::CTR }) {
+        CipherContext zeros(std::make_unique<DES>(), key, mode, PaddingScheme::Zeros, iv);
+        write_file(plain, data);
+        zeros.encrypt(plain, encrypted).get();
+        zeros.decrypt(encrypted, decrypted).get();
+        byte_array ciphertext, in_memory;
+        zeros.encrypt(data, ciphertext).get();
+        zeros.decrypt(ciphertext, in_memory).get();
+        if (read_file(decrypted) == in_memory && in_memory.size() == chunk - 16)
+            std::cout << "Zeros padding across chunk boundary OK\n";
+        else
+            std::cout << "Mismatch: zeros padding stripped differently in file mode\n";
+    }
+    fs::remove(plain);
+    fs::remove(encrypted);
+    fs::remove(decrypted);
+}
+
 int main() {
     try {
+        test_compiled_permutations();
+        test_triple_des_vectors();
+
         fs::path test_dir = "test_files";
         if (!fs::exists(test_dir)) {
             std::cout << "test_files directory not found.\n";
@@ -93,6 +258,7 @@ int main() {
         }
         fs::current_path(test_dir);
         std::cout << "Current directory: " << fs::current_path() << "\n";
+        test_file_edge_cases();
 
         std::vector<std::string> files = {
                 "Homework.docx",
@@ -117,6 +283,7 @@ int main() {
                 std::cout << "File not found: " << file << std::endl;
                 continue;
             }
+            test_triple_des(file);
             for (auto mode : modes) {
                 try {
                     test_mode(file, mode, padding);
@@ -125,9 +292,7 @@ int main() {
                     std::cerr << "ERROR during test: " << ex.what() << std::endl;
                 }
             }
-            ExtraParams delta_params;
-            byte_array delta_value = {0xDE, 0xAD, 0xBE, 0xEF, 0xFE, 0xED, 0xFA, 0xCE};
-            delta_params["delta"] = delta_value;
+            RandomDeltaParams delta_params{{0xDE, 0xAD, 0xBE, 0xEF, 0xFE, 0xED, 0xFA, 0xCE}};
             test_mode(file, CipherMode::RANDOM_DELTA, padding, delta_params);
         }
     }
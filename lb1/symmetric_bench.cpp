@@ -0,0 +1,475 @@
+//
+// Замеры симметричного стека: P-блоки, функция раунда и расписание ключей DES, одиночные блоки
+// DES/3DES/DEAL, все режимы CipherContext со всеми дополнениями на буферах от 64 Б и файловый путь.
+// Результат - JSON (МБ/с, тактов на байт, выделений памяти на блок) для отслеживания регрессий.
+//
+// Запуск: symmetric_bench [--filter подстрока] [--min-time сек] [--max-size 1M|64M|1G]
+//                         [--file-dir каталог] [--out файл.json]
+//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "DES.h"
+#include "DEAL.h"
+#include "TripleDES.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAS_TSC 1
+#else
+#define BENCH_HAS_TSC 0
+#endif
+
+using namespace DES_Implementation;
+namespace fs = std::filesystem;
+
+// Счетчик выделений: глобальные operator new/delete подменяются только в этой программе.
+// new[] и delete[] по умолчанию вызывают их же. noinline: встроенная пара malloc/free иначе
+// сбивает проверку -Wmismatched-new-delete у GCC.
+namespace {
+    std::atomic<uint64_t> g_allocations{0};
+}
+
+__attribute__((noinline)) void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+__attribute__((noinline)) void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+namespace {
+    struct BenchOptions {
+        std::string filter;
+        double min_time = 0.1;
+        size_t max_size = size_t(1) << 20;
+        std::string file_dir;
+        std::string out;
+    };
+
+    struct BenchResult {
+        std::string name;
+        uint64_t iterations;
+        size_t bytes_per_iteration;   // 0 - операция без объема данных (расписание ключей)
+        size_t blocks_per_iteration;
+        double seconds;
+        uint64_t cycles;
+        uint64_t allocations;
+    };
+
+    uint64_t read_cycles() {
+#if BENCH_HAS_TSC
+        return __rdtsc();
+#else
+        return 0;
+#endif
+    }
+
+    // Не дает компилятору выбросить результат замеряемой операции
+    template <typename T>
+    void do_not_optimize(const T& value) {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    class BenchRunner {
+    public:
+        explicit BenchRunner(const BenchOptions& options) : m_options(options) {}
+
+        bool selected(const std::string& name) const {
+            return m_options.filter.empty() || name.find(m_options.filter) != std::string::npos;
+        }
+
+        // body выполняется пачками, размер пачки удваивается, пока суммарное время меньше min_time;
+        // первый вызов - прогрев, в замер не входит
+        void run(const std::string& name, size_t bytes, size_t blocks, const std::function<void()>& body) {
+            if (!selected(name)) {
+                return;
+            }
+            body();
+
+            uint64_t iterations = 0;
+            uint64_t batch = 1;
+            double seconds = 0;
+            uint64_t cycles = 0;
+            uint64_t allocations = 0;
+            while (seconds < m_options.min_time) {
+                const uint64_t allocations_before = g_allocations.load(std::memory_order_relaxed);
+                const auto start = std::chrono::steady_clock::now();
+                const uint64_t cycles_start = read_cycles();
+                for (uint64_t i = 0; i < batch; ++i) {
+                    body();
+                }
+                cycles += read_cycles() - cycles_start;
+                seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                allocations += g_allocations.load(std::memory_order_relaxed) - allocations_before;
+                iterations += batch;
+                batch *= 2;
+            }
+            m_results.push_back({name, iterations, bytes, blocks, seconds, cycles, allocations});
+            std::cerr << name << ": " << iterations << " iterations, " << seconds << " s" << std::endl;
+        }
+
+        void write_json(std::ostream& out) const {
+            out << "{\n  \"context\": {\n";
+            out << "    \"cpu_tier\": \"" << CpuDispatch::tier_name(CpuDispatch::kernels().tier) << "\",\n";
+            out << "    \"bmi2\": " << (CpuDispatch::kernels().bmi2 ? "true" : "false") << ",\n";
+            out << "    \"hardware_concurrency\": " << std::thread::hardware_concurrency() << ",\n";
+            out << "    \"cycle_counter\": \"" << (BENCH_HAS_TSC ? "tsc" : "none") << "\",\n";
+            out << "    \"min_time\": " << m_options.min_time << ",\n";
+            out << "    \"max_size\": " << m_options.max_size << "\n";
+            out << "  },\n  \"benchmarks\": [";
+            for (size_t i = 0; i < m_results.size(); ++i) {
+                const BenchResult& r = m_results[i];
+                const double iterations = static_cast<double>(r.iterations);
+                const double total_bytes = iterations * static_cast<double>(r.bytes_per_iteration);
+                const double total_blocks = iterations * static_cast<double>(r.blocks_per_iteration);
+                out << (i ? ",\n" : "\n") << "    {\"name\": \"" << r.name << "\""
+                    << ", \"iterations\": " << r.iterations
+                    << ", \"ns_per_iteration\": " << r.seconds * 1e9 / iterations
+                    << ", \"bytes_per_iteration\": " << r.bytes_per_iteration;
+                if (r.bytes_per_iteration > 0) {
+                    out << ", \"mb_per_s\": " << total_bytes / r.seconds / 1e6;
+                    if (BENCH_HAS_TSC) {
+                        out << ", \"cycles_per_byte\": " << static_cast<double>(r.cycles) / total_bytes;
+                    }
+                } else if (BENCH_HAS_TSC) {
+                    out << ", \"cycles_per_iteration\": " << static_cast<double>(r.cycles) / iterations;
+                }
+                out << ", \"allocations_per_block\": " << static_cast<double>(r.allocations) / total_blocks << "}";
+            }
+            out << "\n  ]\n}\n";
+        }
+
+    private:
+        const BenchOptions& m_options;
+        std::vector<BenchResult> m_results;
+    };
+
+    size_t parse_size(const std::string& text) {
+        size_t pos = 0;
+        const unsigned long long value = std::stoull(text, &pos);
+        const std::string suffix = text.substr(pos);
+        if (suffix.empty() || suffix == "B") return value;
+        if (suffix == "K") return value << 10;
+        if (suffix == "M") return value << 20;
+        if (suffix == "G") return value << 30;
+        throw std::invalid_argument("Unknown size suffix: " + text);
+    }
+
+    std::string size_name(size_t bytes) {
+        if (bytes >= (size_t(1) << 30) && bytes % (size_t(1) << 30) == 0) return std::to_string(bytes >> 30) + "G";
+        if (bytes >= (size_t(1) << 20) && bytes % (size_t(1) << 20) == 0) return std::to_string(bytes >> 20) + "M";
+        if (bytes >= (size_t(1) << 10) && bytes % (size_t(1) << 10) == 0) return std::to_string(bytes >> 10) + "K";
+        return std::to_string(bytes);
+    }
+
+    // 64 Б, 4 КБ, 256 КБ, 16 МБ, 1 ГБ - не больше max_size
+    std::vector<size_t> buffer_sizes(size_t max_size) {
+        std::vector<size_t> sizes;
+        for (size_t size = 64; size <= max_size; size *= 64) {
+            sizes.push_back(size);
+        }
+        if (sizes.empty() || sizes.back() != max_size) {
+            sizes.push_back(max_size);
+        }
+        return sizes;
+    }
+
+    byte_array random_bytes(size_t size, std::mt19937& rng) {
+        byte_array data(size);
+        for (auto& b : data) {
+            b = static_cast<unsigned char>(rng());
+        }
+        return data;
+    }
+
+    // Случайная таблица P-блока (1-based, big-endian, как таблицы DES): output_bits выходов из input_bits
+    std::vector<int> random_p_block(size_t input_bits, size_t output_bits, std::mt19937& rng) {
+        std::vector<int> table;
+        while (table.size() < output_bits) {
+            std::vector<int> round(input_bits);
+            for (size_t i = 0; i < input_bits; ++i) round[i] = static_cast<int>(i + 1);
+            std::shuffle(round.begin(), round.end(), rng);
+            table.insert(table.end(), round.begin(), round.begin() + std::min(input_bits, output_bits - table.size()));
+        }
+        return table;
+    }
+
+    const char* mode_name(CipherMode mode) {
+        switch (mode) {
+            case CipherMode::ECB: return "ECB";
+            case CipherMode::CBC: return "CBC";
+            case CipherMode::PCBC: return "PCBC";
+            case CipherMode::CFB: return "CFB";
+            case CipherMode::OFB: return "OFB";
+            case CipherMode::CTR: return "CTR";
+            case CipherMode::RANDOM_DELTA: return "RANDOM_DELTA";
+        }
+        return "Other";
+    }
+
+    const char* padding_name(PaddingScheme padding) {
+        switch (padding) {
+            case PaddingScheme::Zeros: return "Zeros";
+            case PaddingScheme::ANSI_X923: return "ANSI_X923";
+            case PaddingScheme::PKCS7: return "PKCS7";
+            case PaddingScheme::ISO_10126: return "ISO_10126";
+        }
+        return "Other";
+    }
+
+    const CipherMode ALL_MODES[] = {CipherMode::ECB, CipherMode::CBC, CipherMode::PCBC, CipherMode::CFB,
+                                    CipherMode::OFB, CipherMode::CTR, CipherMode::RANDOM_DELTA};
+    const PaddingScheme ALL_PADDINGS[] = {PaddingScheme::Zeros, PaddingScheme::ANSI_X923, PaddingScheme::PKCS7,
+                                          PaddingScheme::ISO_10126};
+
+    const byte_array DES_KEY = {0x13, 0x34, 0x57, 0x79, 0x9B, 0xBC, 0xDF, 0xF1};
+    const byte_array TRIPLE_DES_KEY = {0x13, 0x34, 0x57, 0x79, 0x9B, 0xBC, 0xDF, 0xF1,
+                                       0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF,
+                                       0xFE, 0xDC, 0xBA, 0x98, 0x76, 0x54, 0x32, 0x10};
+
+    struct AlgorithmSpec {
+        std::string name;
+        std::function<std::unique_ptr<ISymmetricCipher>()> make;
+        byte_array key;
+    };
+
+    std::vector<AlgorithmSpec> algorithms() {
+        return {
+                {"DES", [] { return std::make_unique<DES>(); }, DES_KEY},
+                {"TripleDES_EDE3", [] { return std::make_unique<TripleDES>(TripleDES_Variant::EDE3); }, TRIPLE_DES_KEY},
+                {"DEAL_128_6", [] { return std::make_unique<DEAL>(DEAL_Variant::DEAL_128_6); }, byte_array(16, 0x11)},
+                {"DEAL_192_6", [] { return std::make_unique<DEAL>(DEAL_Variant::DEAL_192_6); }, byte_array(24, 0x22)},
+                {"DEAL_256_8", [] { return std::make_unique<DEAL>(DEAL_Variant::DEAL_256_8); }, byte_array(32, 0x33)},
+        };
+    }
+
+    std::unique_ptr<CipherContext> make_context(const AlgorithmSpec& spec, CipherMode mode, PaddingScheme padding) {
+        std::unique_ptr<ISymmetricCipher> algorithm = spec.make();
+        const size_t block_size = algorithm->getBlockSize();
+        ModeParams params;
+        if (mode == CipherMode::RANDOM_DELTA) {
+            params = RandomDeltaParams{byte_array(block_size, 0xDD)};
+        }
+        std::optional<byte_array> iv;
+        if (mode != CipherMode::ECB) {
+            iv = byte_array(block_size, 0x1A);
+        }
+        return std::make_unique<CipherContext>(std::move(algorithm), spec.key, mode, padding, iv, params);
+    }
+
+    void bench_permutations(BenchRunner& runner, std::mt19937& rng) {
+        const std::vector<int> p64 = random_p_block(64, 64, rng);
+        const std::vector<int> e32 = random_p_block(32, 48, rng);
+        const byte_array input64 = random_bytes(8, rng);
+        const byte_array input32 = random_bytes(4, rng);
+
+        runner.run("permute/64x64", 8, 1, [&] {
+            do_not_optimize(permute(input64, p64, BitDir::BIG_END, BitBase::ONE_BASE));
+        });
+        runner.run("permute/32x48", 4, 1, [&] {
+            do_not_optimize(permute(input32, e32, BitDir::BIG_END, BitBase::ONE_BASE));
+        });
+
+        const CompiledPermutation compiled64(p64, BitDir::BIG_END, BitBase::ONE_BASE, 8);
+        const CompiledPermutation compiled32(e32, BitDir::BIG_END, BitBase::ONE_BASE, 4);
+        uint64_t word64 = bytes_to_word(input64.data(), 8);
+        runner.run("CompiledPermutation::apply/64x64", 8, 1, [&] {
+            word64 = compiled64.apply(word64);
+            do_not_optimize(word64);
+        });
+        uint64_t word32 = bytes_to_word(input32.data(), 4);
+        runner.run("CompiledPermutation::apply/32x48", 4, 1, [&] {
+            do_not_optimize(compiled32.apply(word32));
+            ++word32;
+        });
+        runner.run("CompiledPermutation::apply_bytes/64x64", 8, 1, [&] {
+            do_not_optimize(compiled64.apply(input64));
+        });
+    }
+
+    void bench_des_parts(BenchRunner& runner, std::mt19937& rng) {
+        DESRoundFunction round_function;
+        const byte_array half_block = random_bytes(4, rng);
+        const byte_array round_key = random_bytes(6, rng);
+        runner.run("DESRoundFunction::apply", 4, 1, [&] {
+            do_not_optimize(round_function.apply(half_block, round_key));
+        });
+        uint32_t half_word = static_cast<uint32_t>(bytes_to_word(half_block.data(), 4));
+        const uint64_t key_word = bytes_to_word(round_key.data(), 6);
+        runner.run("DESRoundFunction::applyWord", 4, 1, [&] {
+            half_word = DESRoundFunction::applyWord(half_word, key_word);
+            do_not_optimize(half_word);
+        });
+
+        DESKeyExpander expander;
+        runner.run("DESKeyExpander::generateRoundKeys", 0, 1, [&] {
+            do_not_optimize(expander.generateRoundKeys(DES_KEY));
+        });
+    }
+
+    void bench_single_blocks(BenchRunner& runner, std::mt19937& rng) {
+        for (const AlgorithmSpec& spec : algorithms()) {
+            std::unique_ptr<ISymmetricCipher> cipher = spec.make();
+            cipher->setKey(spec.key);
+            const size_t block_size = cipher->getBlockSize();
+            byte_array block = random_bytes(block_size, rng);
+            runner.run(spec.name + "/encryptBlock", block_size, 1, [&] {
+                block = cipher->encryptBlock(block);
+            });
+            runner.run(spec.name + "/decryptBlock", block_size, 1, [&] {
+                block = cipher->decryptBlock(block);
+            });
+        }
+    }
+
+    // DES - все режимы со всеми дополнениями; 3DES и DEAL - CBC (последовательный) и CTR (параллельный)
+    void bench_modes(BenchRunner& runner, const BenchOptions& options, std::mt19937& rng) {
+        const std::vector<AlgorithmSpec> specs = algorithms();
+        const std::vector<size_t> sizes = buffer_sizes(options.max_size);
+        for (const AlgorithmSpec& spec : specs) {
+            for (CipherMode mode : ALL_MODES) {
+                for (PaddingScheme padding : ALL_PADDINGS) {
+                    const bool full_matrix = spec.name == "DES";
+                    if (!full_matrix && !(padding == PaddingScheme::PKCS7 &&
+                                          (mode == CipherMode::CBC || mode == CipherMode::CTR))) {
+                        continue;
+                    }
+                    const std::string prefix = "CipherContext/" + spec.name + "/" + mode_name(mode) + "/" +
+                                               padding_name(padding) + "/";
+                    if (!runner.selected(prefix)) {
+                        continue;
+                    }
+                    std::unique_ptr<CipherContext> ctx = make_context(spec, mode, padding);
+                    const size_t block_size = ctx->getBlockSize();
+                    for (size_t size : sizes) {
+                        const byte_array plaintext = random_bytes(size, rng);
+                        const size_t blocks = (size + block_size - 1) / block_size;
+                        byte_array ciphertext;
+                        byte_array decrypted;
+                        ctx->encrypt(plaintext, ciphertext).get();
+                        runner.run(prefix + "encrypt/" + size_name(size), size, blocks, [&] {
+                            ctx->encrypt(plaintext, ciphertext).get();
+                        });
+                        runner.run(prefix + "decrypt/" + size_name(size), size, blocks, [&] {
+                            ctx->decrypt(ciphertext, decrypted).get();
+                        });
+                    }
+                }
+            }
+        }
+    }
+
+    // Файловый путь (потоковая обработка частями): DES во всех режимах с PKCS7 на файле max_size
+    void bench_files(BenchRunner& runner, const BenchOptions& options, std::mt19937& rng) {
+        const fs::path dir = options.file_dir.empty() ? fs::temp_directory_path() : fs::path(options.file_dir);
+        const fs::path plain_path = dir / "symmetric_bench.bin";
+        const fs::path encrypted_path = dir / "symmetric_bench.bin.enc";
+        const fs::path decrypted_path = dir / "symmetric_bench.bin.dec";
+        const size_t size = options.max_size;
+
+        bool written = false;
+        const AlgorithmSpec des = algorithms().front();
+        for (CipherMode mode : ALL_MODES) {
+            const std::string prefix = std::string("File/DES/") + mode_name(mode) + "/PKCS7/";
+            if (!runner.selected(prefix)) {
+                continue;
+            }
+            if (!written) {
+                const byte_array data = random_bytes(size, rng);
+                std::ofstream out(plain_path, std::ios::binary);
+                out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+                if (!out) {
+                    throw std::runtime_error("Cannot write " + plain_path.string());
+                }
+                written = true;
+            }
+            std::unique_ptr<CipherContext> ctx = make_context(des, mode, PaddingScheme::PKCS7);
+            const size_t blocks = (size + 7) / 8;
+            ctx->encrypt(plain_path.string(), encrypted_path.string()).get();
+            runner.run(prefix + "encrypt/" + size_name(size), size, blocks, [&] {
+                ctx->encrypt(plain_path.string(), encrypted_path.string()).get();
+            });
+            runner.run(prefix + "decrypt/" + size_name(size), size, blocks, [&] {
+                ctx->decrypt(encrypted_path.string(), decrypted_path.string()).get();
+            });
+        }
+        if (written) {
+            fs::remove(plain_path);
+            fs::remove(encrypted_path);
+            fs::remove(decrypted_path);
+        }
+    }
+
+    BenchOptions parse_options(int argc, char** argv) {
+        BenchOptions options;
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("Missing value for " + arg);
+            }
+            const std::string value = argv[++i];
+            if (arg == "--filter") options.filter = value;
+            else if (arg == "--min-time") options.min_time = std::stod(value);
+            else if (arg == "--max-size") options.max_size = parse_size(value);
+            else if (arg == "--file-dir") options.file_dir = value;
+            else if (arg == "--out") options.out = value;
+            else throw std::invalid_argument("Unknown option: " + arg);
+        }
+        if (options.max_size < 64) {
+            throw std::invalid_argument("--max-size must be at least 64 bytes");
+        }
+        return options;
+    }
+}
+
+int main(int argc, char** argv) {
+    try {
+        const BenchOptions options = parse_options(argc, argv);
+        BenchRunner runner(options);
+        std::mt19937 rng(20251031);
+
+        bench_permutations(runner, rng);
+        bench_des_parts(runner, rng);
+        bench_single_blocks(runner, rng);
+        bench_modes(runner, options, rng);
+        bench_files(runner, options, rng);
+
+        if (options.out.empty()) {
+            runner.write_json(std::cout);
+        } else {
+            std::ofstream out(options.out);
+            runner.write_json(out);
+            if (!out) {
+                throw std::runtime_error("Cannot write " + options.out);
+            }
+        }
+    }
+    catch (const std::exception& ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
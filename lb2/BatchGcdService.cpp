@@ -0,0 +1,262 @@
+#include "BatchGcdService.h"
+#include "StatelessService.h"
+#include "ParallelFor.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+    constexpr size_t READ_BATCH_SIZE = 65536;
+
+    std::runtime_error system_error(const std::string& what) {
+        return std::runtime_error(what + ": " + std::strerror(errno));
+    }
+
+    /**
+     * Уровень дерева: неотрицательные числа в памяти или лимбы подряд во временном файле,
+     * отображенном в память (файл удаляется сразу после создания и исчезает при закрытии).
+     */
+    class TreeLevel {
+    public:
+        explicit TreeLevel(std::vector<big_int>&& values) : _values(std::move(values)) {}
+
+        TreeLevel(std::vector<big_int>&& values, const std::string& directory) {
+            // offsets[i] - начало i-го числа в лимбах
+            _offsets.resize(values.size() + 1);
+            for (size_t i = 0; i < values.size(); ++i) {
+                _offsets[i + 1] = _offsets[i] + mpz_size(values[i].backend().data());
+            }
+            const size_t bytes = _offsets.back() * sizeof(mp_limb_t);
+
+            std::string path = (std::filesystem::path(directory) / "batch_gcd_XXXXXX").string();
+            _fd = mkstemp(path.data());
+            if (_fd < 0) {
+                throw system_error("Не удалось создать временный файл в " + directory);
+            }
+            unlink(path.c_str());
+            for (const big_int& value : values) {
+                const mpz_srcptr z = value.backend().data();
+                const char* data = reinterpret_cast<const char*>(mpz_limbs_read(z));
+                size_t left = mpz_size(z) * sizeof(mp_limb_t);
+                while (left > 0) {
+                    const ssize_t written = write(_fd, data, left);
+                    if (written < 0) {
+                        close(_fd);
+                        throw system_error("Ошибка записи уровня дерева на диск");
+                    }
+                    data += written;
+                    left -= static_cast<size_t>(written);
+                }
+            }
+            values.clear();
+            values.shrink_to_fit();
+            if (bytes > 0) {
+                void* mapped = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, _fd, 0);
+                if (mapped == MAP_FAILED) {
+                    close(_fd);
+                    throw system_error("Не удалось отобразить уровень дерева в память");
+                }
+                _mapped = static_cast<const mp_limb_t*>(mapped);
+                _mapped_bytes = bytes;
+            }
+        }
+
+        ~TreeLevel() {
+            if (_mapped) munmap(const_cast<mp_limb_t*>(_mapped), _mapped_bytes);
+            if (_fd >= 0) close(_fd);
+        }
+
+        TreeLevel(const TreeLevel&) = delete;
+        TreeLevel& operator=(const TreeLevel&) = delete;
+
+        size_t size() const { return _fd >= 0 ? _offsets.size() - 1 : _values.size(); }
+
+        // Число только для чтения; для выгруженного уровня - вид на отображенные лимбы в storage
+        mpz_srcptr get(size_t i, __mpz_struct& storage) const {
+            if (_fd < 0) {
+                return _values[i].backend().data();
+            }
+            const size_t limbs = _offsets[i + 1] - _offsets[i];
+            return mpz_roinit_n(&storage, _mapped + _offsets[i], static_cast<mp_size_t>(limbs));
+        }
+
+    private:
+        std::vector<big_int> _values;
+        std::vector<size_t> _offsets;
+        int _fd = -1;
+        const mp_limb_t* _mapped = nullptr;
+        size_t _mapped_bytes = 0;
+    };
+
+    size_t byte_size(const std::vector<big_int>& values) {
+        size_t limbs = 0;
+        for (const big_int& value : values) {
+            limbs += mpz_size(value.backend().data());
+        }
+        return limbs * sizeof(mp_limb_t);
+    }
+
+    std::unique_ptr<TreeLevel> make_level(std::vector<big_int>&& values, const BatchGcdService::Options& options) {
+        if (byte_size(values) < options.spill_threshold) {
+            return std::make_unique<TreeLevel>(std::move(values));
+        }
+        const std::string directory = options.spill_directory.empty()
+                                      ? std::filesystem::temp_directory_path().string()
+                                      : options.spill_directory;
+        return std::make_unique<TreeLevel>(std::move(values), directory);
+    }
+
+    // Модули должны быть не меньше 2: иначе дерево остатков делит на ноль
+    void check_modulus(const big_int& n) {
+        if (n < 2) {
+            throw std::invalid_argument("Модуль RSA должен быть больше 1");
+        }
+    }
+
+    /**
+     * Ядро пакетного НОД. moduli становятся листовым уровнем (и выгружаются на диск наравне с остальными),
+     * key_at(i, n) восстанавливает ключ только для найденных модулей. Листья живут до конца: из них
+     * же берутся n_i на последнем шаге, поэтому отдельная копия модулей не нужна.
+     */
+    std::vector<SharedFactorHit> audit_moduli(std::vector<big_int>&& moduli,
+                                              const std::function<RsaPublicKey(size_t, const big_int&)>& key_at,
+                                              const BatchGcdService::Options& options) {
+        std::vector<SharedFactorHit> hits;
+        const size_t count = moduli.size();
+        if (count < 2) {
+            return hits;
+        }
+        const unsigned threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+
+        // Дерево произведений: уровень 0 - модули, вершина - произведение всех
+        std::vector<std::unique_ptr<TreeLevel>> tree;
+        tree.push_back(make_level(std::move(moduli), options));
+        while (tree.back()->size() > 1) {
+            const TreeLevel& below = *tree.back();
+            std::vector<big_int> level((below.size() + 1) / 2);
+            parallel_for(0, level.size(), threads, 1, [&](size_t i) {
+                __mpz_struct left_storage, right_storage;
+                const mpz_srcptr left = below.get(2 * i, left_storage);
+                if (2 * i + 1 < below.size()) {
+                    mpz_mul(level[i].backend().data(), left, below.get(2 * i + 1, right_storage));
+                } else {
+                    mpz_set(level[i].backend().data(), left);
+                }
+            });
+            tree.push_back(make_level(std::move(level), options));
+        }
+
+        // Дерево остатков: на уровне j остаток P mod (узел)^2. Уровни остатков выгружаются так же, как
+        // уровни произведений; уровень произведений освобождается (и его файл удаляется), как только
+        // остатки под ним посчитаны. Листья остаются до конца
+        std::unique_ptr<TreeLevel> remainders;
+        {
+            std::vector<big_int> top(1);
+            __mpz_struct storage;
+            mpz_set(top[0].backend().data(), tree.back()->get(0, storage));
+            remainders = make_level(std::move(top), options);
+        }
+        tree.pop_back();
+        for (size_t depth = tree.size(); depth-- > 0;) {
+            const TreeLevel& level = *tree[depth];
+            const TreeLevel& above = *remainders;
+            std::vector<big_int> next(level.size());
+            parallel_for(0, next.size(), threads, 1, [&](size_t i) {
+                __mpz_struct node_storage, above_storage;
+                big_int square;
+                const mpz_srcptr node = level.get(i, node_storage);
+                mpz_mul(square.backend().data(), node, node);
+                mpz_mod(next[i].backend().data(), above.get(i / 2, above_storage), square.backend().data());
+            });
+            remainders = make_level(std::move(next), options);
+            if (depth > 0) {
+                tree.pop_back();
+            }
+        }
+        const TreeLevel& leaves = *tree.front();
+
+        // (P mod n_i^2) / n_i = (P / n_i) mod n_i, общий делитель - gcd с n_i
+        std::vector<big_int> factors(count);
+        parallel_for(0, count, threads, 1, [&](size_t i) {
+            __mpz_struct n_storage, remainder_storage;
+            const mpz_srcptr n = leaves.get(i, n_storage);
+            big_int quotient;
+            mpz_divexact(quotient.backend().data(), remainders->get(i, remainder_storage), n);
+            mpz_gcd(factors[i].backend().data(), n, quotient.backend().data());
+        });
+
+        for (size_t i = 0; i < count; ++i) {
+            if (factors[i] != 1) {
+                __mpz_struct storage;
+                big_int n;
+                mpz_set(n.backend().data(), leaves.get(i, storage));
+                hits.push_back({i, key_at(i, n), factors[i], false});
+            }
+        }
+
+        // gcd = n: оба простых встречаются в других модулях (или модуль повторяется) - делитель ищется
+        // попарными НОД среди найденных, их обычно немного
+        for (SharedFactorHit& hit : hits) {
+            if (hit.factor != hit.key.n) {
+                continue;
+            }
+            for (const SharedFactorHit& other : hits) {
+                if (other.index == hit.index) {
+                    continue;
+                }
+                if (other.key.n == hit.key.n) {
+                    hit.duplicate = true;
+                    continue;
+                }
+                if (hit.factor == hit.key.n) {
+                    const big_int common = CryptoService::Gcd(hit.key.n, other.key.n);
+                    if (common != 1 && common != hit.key.n) {
+                        hit.factor = common;
+                    }
+                }
+            }
+        }
+        return hits;
+    }
+}
+
+std::vector<SharedFactorHit> BatchGcdService::Audit(const std::vector<RsaPublicKey>& keys) {
+    return Audit(keys, Options());
+}
+
+std::vector<SharedFactorHit> BatchGcdService::Audit(std::istream& input, const Options& options) {
+    // Из потока в память попадают только модули (сразу будущий листовой уровень) и открытые экспоненты
+    std::vector<big_int> moduli;
+    std::vector<big_int> exponents;
+    std::vector<RsaPublicKey> batch;
+    size_t line_number = 0;
+    while (ReadPublicKeys(input, batch, READ_BATCH_SIZE, line_number)) {
+        for (RsaPublicKey& key : batch) {
+            check_modulus(key.n);
+            moduli.push_back(std::move(key.n));
+            exponents.push_back(std::move(key.e));
+        }
+    }
+    return audit_moduli(std::move(moduli), [&](size_t i, const big_int& n) {
+        return RsaPublicKey{n, exponents[i]};
+    }, options);
+}
+
+std::vector<SharedFactorHit> BatchGcdService::Audit(const std::vector<RsaPublicKey>& keys, const Options& options) {
+    std::vector<big_int> moduli;
+    moduli.reserve(keys.size());
+    for (const RsaPublicKey& key : keys) {
+        check_modulus(key.n);
+        moduli.push_back(key.n);
+    }
+    return audit_moduli(std::move(moduli), [&](size_t i, const big_int&) { return keys[i]; }, options);
+}
@@ -0,0 +1,57 @@
+#ifndef BATCH_GCD_SERVICE_H
+#define BATCH_GCD_SERVICE_H
+
+#include "RsaService.h" // Нужен для RsaPublicKey
+#include <cstddef>
+#include <istream>
+#include <string>
+#include <vector>
+
+// Модуль, имеющий общий простой делитель с другим модулем набора
+struct SharedFactorHit {
+    size_t index;                   // номер ключа во входных данных (с нуля)
+    RsaPublicKey key;
+    big_int factor;                 // нетривиальный делитель n; n, если модуль не удалось разложить (дубликат)
+    bool duplicate;                 // тот же модуль встречается в наборе еще раз
+};
+
+/**
+ * @class BatchGcdService
+ * @brief Пакетный НОД (Бернштейн): поиск модулей RSA с общим простым делителем во всем наборе сразу.
+ *        Дерево произведений P = n_1 * ... * n_k строится снизу вверх, дерево остатков - сверху вниз
+ *        (P mod n_i^2), затем gcd(n_i, (P mod n_i^2) / n_i) дает общий с остальными модулями делитель.
+ *        Узлы одного уровня считаются параллельно; уровни произведений и остатков больше порога
+ *        выгружаются во временные файлы, отображенные в память, и читаются из них без копирования.
+ *
+ *        Пиковая память при суммарном размере модулей M: уровень, который сейчас строится, целиком
+ *        в памяти (до ~M для уровня произведений и до ~2M для уровня остатков, так как остатки берутся
+ *        по квадратам узлов), плюс невыгруженные уровни меньше spill_threshold, плюс k делителей
+ *        (обычно по одному лимбу). Листья - единственная копия модулей внутри сервиса; для Audit
+ *        по вектору к этому добавляются сами keys вызывающего, для Audit по потоку - только открытые
+ *        экспоненты. На диске - выгруженные уровни произведений (каждый до ~M, всего log2(k) уровней,
+ *        освобождаются по мере спуска по дереву остатков) и не более одного уровня остатков.
+ */
+class BatchGcdService {
+public:
+    BatchGcdService() = delete; // Stateless-сервис
+
+    struct Options {
+        unsigned threads = 0;                       // 0 - по числу ядер
+        size_t spill_threshold = size_t(256) << 20; // уровни от этого размера (байт) уходят на диск
+        std::string spill_directory;                // пусто - системный каталог временных файлов
+    };
+
+    /**
+     * @brief Возвращает все модули с нетривиальным общим делителем, в порядке исходных индексов.
+     * @throws std::invalid_argument при модуле меньше 2.
+     * @throws std::runtime_error при ошибке работы с временными файлами.
+     */
+    static std::vector<SharedFactorHit> Audit(const std::vector<RsaPublicKey>& keys, const Options& options);
+    static std::vector<SharedFactorHit> Audit(const std::vector<RsaPublicKey>& keys);
+    /**
+     * @brief То же для ключей из потока в формате WienerAttackService::Scan ("n e" на строку).
+     */
+    static std::vector<SharedFactorHit> Audit(std::istream& input, const Options& options);
+};
+
+#endif //BATCH_GCD_SERVICE_H
@@ -0,0 +1,504 @@
+#include "BonehDurfeeAttackService.h"
+#include "LatticeReduction.h"
+#include "WienerAttackService.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+    // Многочлен от одной переменной: coef[i] при x^i, без старших нулей
+    using Poly = std::vector<big_int>;
+
+    void trim(Poly& p) {
+        while (!p.empty() && p.back() == 0) {
+            p.pop_back();
+        }
+    }
+
+    Poly poly_mul(const Poly& a, const Poly& b) {
+        if (a.empty() || b.empty()) {
+            return {};
+        }
+        Poly result(a.size() + b.size() - 1);
+        for (size_t i = 0; i < a.size(); ++i) {
+            if (a[i] == 0) continue;
+            for (size_t j = 0; j < b.size(); ++j) {
+                mpz_addmul(result[i + j].backend().data(), a[i].backend().data(), b[j].backend().data());
+            }
+        }
+        trim(result);
+        return result;
+    }
+
+    Poly poly_sub(Poly a, const Poly& b) {
+        if (a.size() < b.size()) {
+            a.resize(b.size());
+        }
+        for (size_t i = 0; i < b.size(); ++i) {
+            a[i] -= b[i];
+        }
+        trim(a);
+        return a;
+    }
+
+    // a / b, деление обязано быть точным (шаг Барейса)
+    Poly poly_divexact(Poly a, const Poly& b) {
+        if (a.empty()) {
+            return {};
+        }
+        const size_t db = b.size() - 1;
+        Poly q(a.size() - db);
+        for (size_t i = a.size(); i-- > db;) {
+            if (a[i] == 0) continue;
+            big_int c;
+            mpz_divexact(c.backend().data(), a[i].backend().data(), b[db].backend().data());
+            for (size_t j = 0; j <= db; ++j) {
+                mpz_submul(a[i - db + j].backend().data(), c.backend().data(), b[j].backend().data());
+            }
+            q[i - db] = std::move(c);
+        }
+        trim(q);
+        return q;
+    }
+
+    big_int poly_eval(const Poly& p, const big_int& x) {
+        big_int result = 0;
+        for (size_t i = p.size(); i-- > 0;) {
+            result *= x;
+            result += p[i];
+        }
+        return result;
+    }
+
+    // p(x) mod modulus, результат в [0, modulus)
+    big_int poly_eval_mod(const Poly& p, const big_int& x, const big_int& modulus) {
+        big_int result = 0;
+        for (size_t i = p.size(); i-- > 0;) {
+            result *= x;
+            result += p[i];
+            mpz_mod(result.backend().data(), result.backend().data(), modulus.backend().data());
+        }
+        return result;
+    }
+
+    bool is_small_prime(unsigned long n) {
+        if (n < 2) return false;
+        for (unsigned long d = 2; d * d <= n; ++d) {
+            if (n % d == 0) return false;
+        }
+        return true;
+    }
+
+    // Определитель матрицы над Z[x] методом Барейса: все деления точные, коэффициенты не растут
+    // быстрее миноров
+    Poly bareiss_determinant(std::vector<std::vector<Poly>> matrix) {
+        const size_t n = matrix.size();
+        Poly previous = {1};
+        bool negate = false;
+        for (size_t k = 0; k + 1 < n; ++k) {
+            if (matrix[k][k].empty()) {
+                size_t pivot = k + 1;
+                while (pivot < n && matrix[pivot][k].empty()) ++pivot;
+                if (pivot == n) {
+                    return {};
+                }
+                std::swap(matrix[k], matrix[pivot]);
+                negate = !negate;
+            }
+            for (size_t i = k + 1; i < n; ++i) {
+                for (size_t j = k + 1; j < n; ++j) {
+                    Poly value = poly_sub(poly_mul(matrix[k][k], matrix[i][j]), poly_mul(matrix[i][k], matrix[k][j]));
+                    matrix[i][j] = poly_divexact(std::move(value), previous);
+                }
+                matrix[i][k].clear();
+            }
+            previous = matrix[k][k];
+        }
+        Poly det = std::move(matrix[n - 1][n - 1]);
+        if (negate) {
+            for (auto& c : det) c = -c;
+        }
+        return det;
+    }
+}
+
+BonehDurfeeAttackResult BonehDurfeeAttackService::Attack(const RsaPublicKey& publicKey) {
+    return Attack(publicKey, DEFAULT_DELTA);
+}
+
+double BonehDurfeeAttackService::_lattice_slack(double log_e, double log_x, double log_y, int m, int t, int& dimension) {
+    double log_det = 0;
+    int w = 0;
+    for (int k = 0; k <= m; ++k) {
+        for (int i = 0; i <= m - k; ++i, ++w) {
+            log_det += (m - k) * log_e + (i + k) * log_x + k * log_y;
+        }
+    }
+    for (int j = 1; j <= t; ++j) {
+        for (int k = 0; k <= m; ++k, ++w) {
+            log_det += (m - k) * log_e + k * log_x + (k + j) * log_y;
+        }
+    }
+    dimension = w;
+    return w * m * log_e - log_det;
+}
+
+std::pair<int, int> BonehDurfeeAttackService::_choose_parameters(double log_e, double log_x, double log_y, int m) {
+    // Корень сохраняется над Z, если векторы короче e^m / sqrt(w). На практике LLL находит такие векторы,
+    // когда det < e^(m*w) для фактических размеров корня (log_x, log_y), а не для границ X и Y.
+    // Ищем наименьшую размерность w, иначе - пару с наименьшим дефицитом
+    const int m_first = m ? m : 1;
+    const int m_last = m ? m : MAX_AUTO_M;
+    std::pair<int, int> best{m_last, 0};
+    double best_slack = -INFINITY;
+    int best_dimension = 0;
+    for (int mm = m_first; mm <= m_last; ++mm) {
+        for (int t = 0; t <= mm; ++t) {
+            int w = 0;
+            const double slack = _lattice_slack(log_e, log_x, log_y, mm, t, w);
+            const bool feasible = slack > 0;
+            const bool best_feasible = best_slack > 0;
+            if ((feasible && (!best_feasible || w < best_dimension)) || (!feasible && !best_feasible && slack > best_slack)) {
+                best = {mm, t};
+                best_slack = slack;
+                best_dimension = w;
+            }
+        }
+    }
+    return best;
+}
+
+std::vector<std::vector<big_int>> BonehDurfeeAttackService::_build_lattice(
+        const big_int& e, const big_int& a, const big_int& x_bound, const big_int& y_bound, int m, int t,
+        std::vector<std::pair<int, int>>& monomials) {
+    // Мономы в порядке старших членов сдвигов: x^i f^k -> x^(i+k) y^k, y^j f^k -> x^k y^(k+j),
+    // при таком порядке матрица нижнетреугольная
+    monomials.clear();
+    for (int deg = 0; deg <= m; ++deg) {
+        for (int k = 0; k <= deg; ++k) {
+            monomials.emplace_back(deg, k);
+        }
+    }
+    for (int j = 1; j <= t; ++j) {
+        for (int k = 0; k <= m; ++k) {
+            monomials.emplace_back(k, k + j);
+        }
+    }
+    std::vector<std::vector<int>> column(m + 1, std::vector<int>(m + t + 1, -1));
+    for (size_t c = 0; c < monomials.size(); ++c) {
+        column[monomials[c].first][monomials[c].second] = static_cast<int>(c);
+    }
+
+    // f^k, f = 1 + a*x + x*y
+    std::vector<Bivariate> f_power(m + 1, Bivariate(m + 1, std::vector<big_int>(m + 1)));
+    f_power[0][0][0] = 1;
+    for (int k = 1; k <= m; ++k) {
+        const Bivariate& prev = f_power[k - 1];
+        Bivariate& cur = f_power[k];
+        for (int i = 0; i < k; ++i) {
+            for (int j = 0; j <= i; ++j) {
+                if (prev[i][j] == 0) continue;
+                cur[i][j] += prev[i][j];
+                mpz_addmul(cur[i + 1][j].backend().data(), a.backend().data(), prev[i][j].backend().data());
+                cur[i + 1][j + 1] += prev[i][j];
+            }
+        }
+    }
+
+    std::vector<big_int> x_power(m + 1), y_power(m + t + 1), e_power(m + 1);
+    x_power[0] = y_power[0] = e_power[0] = 1;
+    for (int i = 1; i <= m; ++i) {
+        x_power[i] = x_power[i - 1] * x_bound;
+        e_power[i] = e_power[i - 1] * e;
+    }
+    for (int i = 1; i <= m + t; ++i) {
+        y_power[i] = y_power[i - 1] * y_bound;
+    }
+
+    // строка - коэффициенты g(x*X, y*Y) для сдвига x^dx y^dy f^k e^(m-k)
+    const size_t dimension = monomials.size();
+    auto shift_row = [&](int dx, int dy, int k) {
+        std::vector<big_int> row(dimension);
+        for (int i = 0; i <= k; ++i) {
+            for (int j = 0; j <= i; ++j) {
+                if (f_power[k][i][j] == 0) continue;
+                const int ax = i + dx;
+                const int ay = j + dy;
+                big_int& cell = row[column[ax][ay]];
+                cell = f_power[k][i][j] * e_power[m - k];
+                cell *= x_power[ax];
+                cell *= y_power[ay];
+            }
+        }
+        return row;
+    };
+
+    std::vector<std::vector<big_int>> basis;
+    basis.reserve(dimension);
+    for (const auto& monomial : monomials) {
+        const int ax = monomial.first;
+        const int ay = monomial.second;
+        if (ay <= ax) {
+            basis.push_back(shift_row(ax - ay, 0, ay));   // x-сдвиг: i = ax - k, k = ay
+        } else {
+            basis.push_back(shift_row(0, ay - ax, ax));   // y-сдвиг: j = ay - k, k = ax
+        }
+    }
+    return basis;
+}
+
+std::vector<big_int> BonehDurfeeAttackService::_resultant_y(const Bivariate& h1, const Bivariate& h2) {
+    // коэффициенты при y^b как многочлены от x
+    auto by_y = [](const Bivariate& h) {
+        std::vector<Poly> result;
+        for (size_t a = 0; a < h.size(); ++a) {
+            for (size_t b = 0; b < h[a].size(); ++b) {
+                if (h[a][b] == 0) continue;
+                if (result.size() <= b) result.resize(b + 1);
+                if (result[b].size() <= a) result[b].resize(a + 1);
+                result[b][a] = h[a][b];
+            }
+        }
+        return result;
+    };
+    // множители x^a и y^b (общие у коротких векторов) не нужны: x0 != 0 и y0 != 0;
+    // целое содержание тоже сокращается - коэффициенты результанта меньше
+    auto normalize = [](std::vector<Poly> c) {
+        size_t low_y = 0;
+        while (low_y < c.size() && c[low_y].empty()) ++low_y;
+        c.erase(c.begin(), c.begin() + static_cast<std::ptrdiff_t>(low_y));
+        size_t low_x = SIZE_MAX;
+        for (const Poly& p : c) {
+            for (size_t a = 0; a < p.size() && a < low_x; ++a) {
+                if (p[a] != 0) { low_x = a; break; }
+            }
+        }
+        big_int content = 0;
+        for (Poly& p : c) {
+            p.erase(p.begin(), p.begin() + static_cast<std::ptrdiff_t>(std::min(low_x, p.size())));
+            for (const big_int& coef : p) {
+                mpz_gcd(content.backend().data(), content.backend().data(), coef.backend().data());
+            }
+        }
+        if (content > 1) {
+            for (Poly& p : c) {
+                for (big_int& coef : p) {
+                    mpz_divexact(coef.backend().data(), coef.backend().data(), content.backend().data());
+                }
+            }
+        }
+        return c;
+    };
+    const std::vector<Poly> c1 = normalize(by_y(h1));
+    const std::vector<Poly> c2 = normalize(by_y(h2));
+    if (c1.empty() || c2.empty()) {
+        return {};
+    }
+    // многочлен без y: корни результанта совпадают с его корнями
+    if (c1.size() == 1) return c1[0];
+    if (c2.size() == 1) return c2[0];
+
+    // матрица Сильвестра
+    const size_t d1 = c1.size() - 1;
+    const size_t d2 = c2.size() - 1;
+    const size_t n = d1 + d2;
+    std::vector<std::vector<Poly>> sylvester(n, std::vector<Poly>(n));
+    for (size_t i = 0; i < d2; ++i) {
+        for (size_t b = 0; b <= d1; ++b) {
+            sylvester[i][i + d1 - b] = c1[b];
+        }
+    }
+    for (size_t i = 0; i < d1; ++i) {
+        for (size_t b = 0; b <= d2; ++b) {
+            sylvester[d2 + i][i + d2 - b] = c2[b];
+        }
+    }
+    return bareiss_determinant(std::move(sylvester));
+}
+
+std::vector<big_int> BonehDurfeeAttackService::_integer_roots(std::vector<big_int> poly, const big_int& bound) {
+    std::vector<big_int> roots;
+    trim(poly);
+    // корень 0 не нужен (k > 0)
+    size_t low = 0;
+    while (low < poly.size() && poly[low] == 0) ++low;
+    poly.erase(poly.begin(), poly.begin() + static_cast<std::ptrdiff_t>(low));
+    if (poly.size() < 2) {
+        return roots;
+    }
+    Poly derivative(poly.size() - 1);
+    for (size_t i = 1; i < poly.size(); ++i) {
+        derivative[i - 1] = poly[i] * static_cast<unsigned long>(i);
+    }
+
+    // Корни по модулю малого простого p поднимаются по Гензелю (Ньютон с удвоением точности)
+    // до модуля больше 2*bound; подходит p, по которому все корни простые
+    const big_int target = 2 * bound + 1;
+    int primes_tried = 0;
+    for (unsigned long p = 1009; primes_tried < 16; p += 2) {
+        if (!is_small_prime(p)) continue;
+        ++primes_tried;
+        if (mpz_fdiv_ui(poly.back().backend().data(), p) == 0) continue;
+
+        std::vector<unsigned long> reduced(poly.size()), reduced_derivative(derivative.size());
+        for (size_t i = 0; i < poly.size(); ++i) reduced[i] = mpz_fdiv_ui(poly[i].backend().data(), p);
+        for (size_t i = 0; i < derivative.size(); ++i) reduced_derivative[i] = mpz_fdiv_ui(derivative[i].backend().data(), p);
+        auto eval_mod_p = [p](const std::vector<unsigned long>& c, unsigned long x) {
+            unsigned long long v = 0;
+            for (size_t i = c.size(); i-- > 0;) {
+                v = (v * x + c[i]) % p;
+            }
+            return v;
+        };
+
+        bool all_simple = true;
+        std::vector<big_int> found;
+        for (unsigned long r = 0; r < p; ++r) {
+            if (eval_mod_p(reduced, r) != 0) continue;
+            if (eval_mod_p(reduced_derivative, r) == 0) {
+                all_simple = false;
+                continue;
+            }
+            big_int x = r;
+            big_int modulus = p;
+            big_int value, slope;
+            while (modulus <= target) {
+                modulus *= modulus;
+                value = poly_eval_mod(poly, x, modulus);
+                slope = poly_eval_mod(derivative, x, modulus);
+                mpz_invert(slope.backend().data(), slope.backend().data(), modulus.backend().data());
+                x -= value * slope;
+                mpz_mod(x.backend().data(), x.backend().data(), modulus.backend().data());
+            }
+            if (2 * x > modulus) {
+                x -= modulus;
+            }
+            if (boost::multiprecision::abs(x) <= bound && poly_eval(poly, x) == 0) {
+                found.push_back(x);
+            }
+        }
+        for (auto& x : found) {
+            if (std::find(roots.begin(), roots.end(), x) == roots.end()) {
+                roots.push_back(std::move(x));
+            }
+        }
+        if (all_simple) {
+            break;
+        }
+    }
+    return roots;
+}
+
+std::optional<big_int> BonehDurfeeAttackService::_test_candidate(const big_int& e, const big_int& n, const big_int& k) {
+    if (k <= 0) {
+        return std::nullopt;
+    }
+    // k*(n + 1 + y0) = -1 (mod e)  =>  y0 = -k^-1 - (n + 1) (mod e), |y0| = p + q < e/2
+    big_int y;
+    if (!mpz_invert(y.backend().data(), k.backend().data(), e.backend().data())) {
+        return std::nullopt;
+    }
+    y = -y - (n + 1);
+    mpz_mod(y.backend().data(), y.backend().data(), e.backend().data());
+    if (2 * y > e) {
+        y -= e;
+    }
+    const big_int s = -y;
+    if (s <= 0) {
+        return std::nullopt;
+    }
+
+    // p и q - корни x^2 - s*x + n
+    big_int discriminant = s * s - 4 * n;
+    if (discriminant < 0 || !mpz_perfect_square_p(discriminant.backend().data())) {
+        return std::nullopt;
+    }
+    const big_int phi = n - s + 1;
+    big_int ed = k * phi + 1;
+    if (!mpz_divisible_p(ed.backend().data(), e.backend().data())) {
+        return std::nullopt;
+    }
+    return phi;
+}
+
+BonehDurfeeAttackResult BonehDurfeeAttackService::Attack(const RsaPublicKey& publicKey, double delta, int m,
+                                                         unsigned threads) {
+    if (!(delta > 0 && delta < 0.3)) {
+        throw std::invalid_argument("delta должно быть в интервале (0, 0.3)");
+    }
+    if (m < 0) {
+        throw std::invalid_argument("m не может быть отрицательным");
+    }
+    const big_int& n = publicKey.n;
+    const big_int& e = publicKey.e;
+    BonehDurfeeAttackResult result{false, 0, 0, 0, 0, 0, false, false};
+
+    // |x0| = k < X = 2^ceil(delta * log2 n), |y0| = p + q < Y = 3 * sqrt(n) для простых одной длины
+    long exponent;
+    const double mantissa = mpz_get_d_2exp(&exponent, n.backend().data());
+    const double log_n = std::log2(mantissa) + static_cast<double>(exponent);
+    const big_int x_bound = big_int(1) << static_cast<unsigned>(std::ceil(delta * log_n));
+    const big_int y_bound = 3 * boost::multiprecision::sqrt(n);
+    const double log_e = std::log2(mpz_get_d_2exp(&exponent, e.backend().data())) + static_cast<double>(exponent);
+    // k ~ n^delta, p + q ~ 2 * sqrt(n)
+    const double log_x = delta * log_n;
+    const double log_y = log_n / 2 + 1;
+
+    const std::pair<int, int> params = _choose_parameters(log_e, log_x, log_y, m);
+    result.m = params.first;
+    result.t = params.second;
+    int dimension = 0;
+    result.insufficient_m = _lattice_slack(log_e, log_x, log_y, result.m, result.t, dimension) <= 0;
+    std::vector<std::pair<int, int>> monomials;
+    std::vector<std::vector<big_int>> basis = _build_lattice(e, n + 1, x_bound, y_bound, result.m, result.t, monomials);
+    result.lattice_dimension = basis.size();
+
+    LatticeReduction::Options options;
+    options.threads = threads;
+    result.exact_lll_fallback = LatticeReduction::Reduce(basis, options).exact_fallback;
+
+    // Самые короткие векторы -> многочлены h(x, y) (коэффициенты делятся на X^a Y^b)
+    const size_t candidates = std::min<size_t>(basis.size(), 6);
+    std::vector<Bivariate> polys;
+    for (size_t v = 0; v < candidates; ++v) {
+        Bivariate h(result.m + 1, std::vector<big_int>(result.m + result.t + 1));
+        for (size_t c = 0; c < monomials.size(); ++c) {
+            const int ax = monomials[c].first;
+            const int ay = monomials[c].second;
+            big_int scale = boost::multiprecision::pow(x_bound, ax) * boost::multiprecision::pow(y_bound, ay);
+            mpz_divexact(h[ax][ay].backend().data(), basis[v][c].backend().data(), scale.backend().data());
+        }
+        polys.push_back(std::move(h));
+    }
+
+    bool independent_pair = false;
+    for (size_t i = 0; i < polys.size(); ++i) {
+        for (size_t j = i + 1; j < polys.size(); ++j) {
+            const std::vector<big_int> resultant = _resultant_y(polys[i], polys[j]);
+            if (resultant.empty()) {
+                continue; // общий множитель - пара бесполезна
+            }
+            independent_pair = true;
+            for (const big_int& k : _integer_roots(resultant, x_bound)) {
+                if (std::optional<big_int> phi = _test_candidate(e, n, k)) {
+                    result.success = true;
+                    result.found_phi = *phi;
+                    result.found_d = (k * *phi + 1) / e;
+                    return result;
+                }
+            }
+        }
+    }
+
+    // При d < n^(1/4) в решетке есть очень короткий k*f - d*e*x = k + (k(p+q) - 1)x + kxy, и все короткие
+    // векторы оказываются его кратными (результанты нулевые). Это область атаки Винера
+    if (!independent_pair) {
+        const WienerAttackResult wiener = WienerAttackService::Attack(publicKey, false);
+        if (wiener.success) {
+            result.success = true;
+            result.found_d = wiener.found_d;
+            result.found_phi = wiener.found_phi;
+        }
+    }
+    return result;
+}
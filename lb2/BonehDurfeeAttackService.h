@@ -0,0 +1,78 @@
+#ifndef BONEH_DURFEE_ATTACK_SERVICE_H
+#define BONEH_DURFEE_ATTACK_SERVICE_H
+
+#include "RsaService.h" // Нужен для RsaPublicKey
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+// Структура для хранения результатов атаки (аналог WienerAttackResult)
+struct BonehDurfeeAttackResult {
+    bool success;                   // Успешна ли была атака
+    big_int found_d;                // Найденная секретная экспонента d
+    big_int found_phi;              // Найденное значение функции Эйлера phi(n)
+    int m;                          // Выбранные параметры решетки: степень сдвигов по x и по y
+    int t;
+    size_t lattice_dimension;       // Размерность решетки
+    bool exact_lll_fallback;        // Понадобился ли точный LLL
+    // Решетка с выбранными (m, t) не удовлетворяет условию на определитель для границы n^delta:
+    // корень найдется только при d заметно меньше границы, неудача не означает стойкости ключа
+    bool insufficient_m;
+};
+
+/**
+ * @class BonehDurfeeAttackService
+ * @brief Атака Боне-Дурфи на малую секретную экспоненту: находит d < n^delta при delta до ~0.28
+ *        (предел атаки Винера - n^0.25). Из e*d = 1 + k*phi следует, что (x0, y0) = (k, -(p+q)) -
+ *        малый корень f(x, y) = 1 + x*(n + 1 + y) по модулю e. Решетка из сдвигов x^i f^k e^(m-k)
+ *        и y^j f^k e^(m-k) приводится LLL (LatticeReduction), два коротких вектора дают многочлены с
+ *        корнем (x0, y0) над Z, x0 - целый корень их результанта по y. При d < n^(1/4) все короткие
+ *        векторы имеют общий множитель и результанты нулевые - тогда d ищется атакой Винера.
+ */
+class BonehDurfeeAttackService {
+public:
+    BonehDurfeeAttackService() = delete; // Stateless-сервис
+
+    static constexpr double DEFAULT_DELTA = 0.26;
+
+    /**
+     * @brief Выполняет атаку на открытый ключ RSA с delta = DEFAULT_DELTA.
+     */
+    static BonehDurfeeAttackResult Attack(const RsaPublicKey& publicKey);
+    /**
+     * @param delta Предполагаемая граница d < n^delta, 0 < delta < 0.3.
+     * @param m Степень сдвигов (0 - подбирается по delta и длине n; больше m - больше размерность и охват).
+     *          Если m мало для delta и длины n (или автоматический выбор не уложился в MAX_AUTO_M),
+     *          атака все равно выполняется, а в результате выставляется insufficient_m.
+     * @param threads Потоки для LLL (0 - по числу ядер).
+     * @throws std::invalid_argument при delta вне (0, 0.3) или отрицательном m.
+     */
+    static BonehDurfeeAttackResult Attack(const RsaPublicKey& publicKey, double delta, int m = 0,
+                                          unsigned threads = 0);
+
+private:
+    static constexpr int MAX_AUTO_M = 10;
+
+    // Плотное представление многочлена от x и y: coef[a][b] при x^a y^b
+    using Bivariate = std::vector<std::vector<big_int>>;
+
+    // Запас log2(e^(m*w)) - log2(det) решетки для (m, t); > 0 - определитель достаточно мал
+    static double _lattice_slack(double log_e, double log_x, double log_y, int m, int t, int& dimension);
+    // Наименьшая по размерности пара (m, t), для которой определитель решетки достаточно мал
+    static std::pair<int, int> _choose_parameters(double log_e, double log_x, double log_y, int m);
+    static std::vector<std::vector<big_int>> _build_lattice(const big_int& e, const big_int& a,
+                                                            const big_int& x_bound, const big_int& y_bound,
+                                                            int m, int t,
+                                                            std::vector<std::pair<int, int>>& monomials);
+    // Целые корни x многочлена, |x| <= bound
+    static std::vector<big_int> _integer_roots(std::vector<big_int> poly, const big_int& bound);
+    // Res_y(h1, h2) как многочлен от x (пустой - результант тождественно равен нулю)
+    static std::vector<big_int> _resultant_y(const Bivariate& h1, const Bivariate& h2);
+    /**
+     * @brief Проверяет кандидата x0 = k: y0 = -(p+q) восстанавливается из f(x0, y0) = 0 (mod e).
+     * @return std::optional<big_int> со значением phi, если кандидат верен, иначе пустой.
+     */
+    static std::optional<big_int> _test_candidate(const big_int& e, const big_int& n, const big_int& k);
+};
+
+#endif //BONEH_DURFEE_ATTACK_SERVICE_H
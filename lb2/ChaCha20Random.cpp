@@ -0,0 +1,160 @@
+#include "ChaCha20Random.h"
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#if defined(__linux__)
+#include <sys/random.h>
+#endif
+
+namespace {
+    inline uint32_t rotl(uint32_t x, int n) {
+        return (x << n) | (x >> (32 - n));
+    }
+
+    inline void quarter_round(uint32_t* x, int a, int b, int c, int d) {
+        x[a] += x[b]; x[d] = rotl(x[d] ^ x[a], 16);
+        x[c] += x[d]; x[b] = rotl(x[b] ^ x[c], 12);
+        x[a] += x[b]; x[d] = rotl(x[d] ^ x[a], 8);
+        x[c] += x[d]; x[b] = rotl(x[b] ^ x[c], 7);
+    }
+
+    void system_random(void* data, size_t size) {
+        unsigned char* out = static_cast<unsigned char*>(data);
+#if defined(__linux__)
+        while (size > 0) {
+            const ssize_t got = getrandom(out, size, 0);
+            if (got < 0) {
+                break;
+            }
+            out += got;
+            size -= static_cast<size_t>(got);
+        }
+#endif
+        // без getrandom (или при ошибке) - std::random_device
+        std::random_device rd;
+        while (size > 0) {
+            const uint32_t word = rd();
+            const size_t n = std::min(size, sizeof(word));
+            std::memcpy(out, &word, n);
+            out += n;
+            size -= n;
+        }
+    }
+}
+
+ChaCha20Random::ChaCha20Random() : _stream(0) {
+    system_random(_key.data(), sizeof(_key));
+}
+
+ChaCha20Random::ChaCha20Random(uint64_t seed, uint64_t stream) : _key(SeedKey(seed)), _stream(stream) {}
+
+ChaCha20Random::ChaCha20Random(const std::array<uint32_t, 8>& key, uint64_t stream) : _key(key), _stream(stream) {}
+
+ChaCha20Random& ChaCha20Random::ThreadLocal() {
+    thread_local ChaCha20Random generator;
+    return generator;
+}
+
+uint64_t ChaCha20Random::SystemSeed() {
+    uint64_t seed;
+    system_random(&seed, sizeof(seed));
+    return seed;
+}
+
+std::array<uint32_t, 8> ChaCha20Random::SystemKey() {
+    std::array<uint32_t, 8> key;
+    system_random(key.data(), sizeof(key));
+    return key;
+}
+
+std::array<uint32_t, 8> ChaCha20Random::SeedKey(uint64_t seed) {
+    std::array<uint32_t, 8> key{};
+    key[0] = static_cast<uint32_t>(seed);
+    key[1] = static_cast<uint32_t>(seed >> 32);
+    return key;
+}
+
+void ChaCha20Random::Block(const std::array<uint32_t, 8>& key, uint64_t counter, uint64_t stream, uint32_t out[16]) {
+    // "expand 32-byte k"
+    const uint32_t input[16] = {
+            0x61707865, 0x3320646e, 0x79622d32, 0x6b206574,
+            key[0], key[1], key[2], key[3], key[4], key[5], key[6], key[7],
+            static_cast<uint32_t>(counter), static_cast<uint32_t>(counter >> 32),
+            static_cast<uint32_t>(stream), static_cast<uint32_t>(stream >> 32)
+    };
+    uint32_t x[16];
+    std::memcpy(x, input, sizeof(x));
+    for (int round = 0; round < 10; ++round) {
+        quarter_round(x, 0, 4, 8, 12);
+        quarter_round(x, 1, 5, 9, 13);
+        quarter_round(x, 2, 6, 10, 14);
+        quarter_round(x, 3, 7, 11, 15);
+        quarter_round(x, 0, 5, 10, 15);
+        quarter_round(x, 1, 6, 11, 12);
+        quarter_round(x, 2, 7, 8, 13);
+        quarter_round(x, 3, 4, 9, 14);
+    }
+    for (int i = 0; i < 16; ++i) {
+        out[i] = x[i] + input[i];
+    }
+}
+
+void ChaCha20Random::_refill() {
+    uint32_t block[16];
+    for (size_t b = 0; b < BUFFER_BLOCKS; ++b) {
+        Block(_key, _counter++, _stream, block);
+        for (size_t i = 0; i < 8; ++i) {
+            _buffer[b * 8 + i] = static_cast<uint64_t>(block[2 * i]) | (static_cast<uint64_t>(block[2 * i + 1]) << 32);
+        }
+    }
+    _position = 0;
+}
+
+uint64_t ChaCha20Random::NextWord() {
+    if (_position == BUFFER_WORDS) {
+        _refill();
+    }
+    return _buffer[_position++];
+}
+
+void ChaCha20Random::Fill(uint64_t* words, size_t count) {
+    while (count > 0) {
+        if (_position == BUFFER_WORDS) {
+            _refill();
+        }
+        const size_t n = std::min(count, BUFFER_WORDS - _position);
+        std::memcpy(words, _buffer.data() + _position, n * sizeof(uint64_t));
+        _position += n;
+        words += n;
+        count -= n;
+    }
+}
+
+big_int ChaCha20Random::Uniform(const big_int& min, const big_int& max) {
+    if (min > max) {
+        throw std::invalid_argument("min > max");
+    }
+    if (min == max) {
+        return min;
+    }
+    const big_int range = max - min;
+    const mpz_srcptr range_z = range.backend().data();
+    const size_t bits = mpz_sizeinbase(range_z, 2);
+    const mp_size_t limbs = static_cast<mp_size_t>((bits + GMP_NUMB_BITS - 1) / GMP_NUMB_BITS);
+    const unsigned top_bits = static_cast<unsigned>(bits - (limbs - 1) * GMP_NUMB_BITS);
+    const mp_limb_t top_mask = top_bits == GMP_NUMB_BITS ? ~mp_limb_t(0) : (mp_limb_t(1) << top_bits) - 1;
+
+    // случайные bits бит прямо в лимбы; значение больше range отбрасывается (вероятность меньше 1/2)
+    big_int result;
+    const mpz_ptr z = result.backend().data();
+    do {
+        mp_limb_t* dst = mpz_limbs_write(z, limbs);
+        static_assert(sizeof(mp_limb_t) == sizeof(uint64_t), "ожидаются 64-битные лимбы");
+        Fill(reinterpret_cast<uint64_t*>(dst), static_cast<size_t>(limbs));
+        dst[limbs - 1] &= top_mask;
+        mpz_limbs_finish(z, limbs);
+    } while (mpz_cmp(z, range_z) > 0);
+    result += min;
+    return result;
+}
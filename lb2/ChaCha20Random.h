@@ -0,0 +1,60 @@
+#ifndef CRYPTOGRAPHY_CHACHA20RANDOM_H
+#define CRYPTOGRAPHY_CHACHA20RANDOM_H
+
+#include <boost/multiprecision/gmp.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+using big_int = boost::multiprecision::mpz_int;
+
+/**
+ * @class ChaCha20Random
+ * @brief Криптографически стойкий генератор на потоке ключа ChaCha20 (вариант Бернштейна:
+ *        64-битный счетчик блоков и 64-битный номер потока).
+ *        Ключевой поток буферизуется по BUFFER_BLOCKS блоков; случайные big_int заполняются
+ *        прямо в лимбы mpz, диапазон выбирается маской старшего лимба и отбором, без деления.
+ *        Объект не потокобезопасен: для общего использования есть ThreadLocal().
+ */
+class ChaCha20Random {
+public:
+    /** @brief Ключ из getrandom, номер потока 0. */
+    ChaCha20Random();
+    /**
+     * @brief Детерминированный поток: одинаковые seed и stream дают одинаковые числа.
+     *        Стойкость не выше 64-битного seed - для воспроизводимых тестов и генерации по seed.
+     */
+    ChaCha20Random(uint64_t seed, uint64_t stream);
+    ChaCha20Random(const std::array<uint32_t, 8>& key, uint64_t stream);
+
+    /** @brief Генератор текущего потока, ключ берется из getrandom при первом обращении. */
+    static ChaCha20Random& ThreadLocal();
+    /** @brief 64 бита из системного источника энтропии. */
+    static uint64_t SystemSeed();
+    /** @brief Полный 256-битный ключ из системного источника энтропии (для недетерминированных потоков). */
+    static std::array<uint32_t, 8> SystemKey();
+    /** @brief Ключ, который использует ChaCha20Random(seed, stream): seed в словах 0..1, остальное - нули. */
+    static std::array<uint32_t, 8> SeedKey(uint64_t seed);
+
+    uint64_t NextWord();
+    void Fill(uint64_t* words, size_t count);
+    /** @brief Равномерно распределенное число из [min, max]. */
+    big_int Uniform(const big_int& min, const big_int& max);
+
+    /** @brief Один блок ChaCha20 (16 слов) для ключа, счетчика и номера потока. */
+    static void Block(const std::array<uint32_t, 8>& key, uint64_t counter, uint64_t stream, uint32_t out[16]);
+
+private:
+    static constexpr size_t BUFFER_BLOCKS = 16;
+    static constexpr size_t BUFFER_WORDS = BUFFER_BLOCKS * 8;
+
+    void _refill();
+
+    std::array<uint32_t, 8> _key;
+    uint64_t _stream;
+    uint64_t _counter = 0;
+    std::array<uint64_t, BUFFER_WORDS> _buffer;
+    size_t _position = BUFFER_WORDS;
+};
+
+#endif //CRYPTOGRAPHY_CHACHA20RANDOM_H
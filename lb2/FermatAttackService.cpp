@@ -0,0 +1,206 @@
+#include "FermatAttackService.h"
+#include <algorithm>
+#include <future>
+#include <iterator>
+#include <thread>
+
+namespace {
+    // 64, 63, 65 и 11 - как в фильтре квадратов атаки Винера, дальше простые до 71:
+    // каждое a проходит все модули с вероятностью меньше 1/1000
+    const unsigned FILTER_MODULI[] = {64, 63, 65, 11, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53, 59, 61, 67, 71};
+
+    big_int ceil_sqrt(const big_int& n) {
+        big_int root;
+        big_int remainder;
+        mpz_sqrtrem(root.backend().data(), remainder.backend().data(), n.backend().data());
+        if (remainder != 0) {
+            ++root;
+        }
+        return root;
+    }
+}
+
+big_int FermatAttackService::StepsToFactor(const big_int& p, const big_int& q) {
+    return (p + q) / 2 - ceil_sqrt(p * q);
+}
+
+FermatAttackService::ResidueFilter FermatAttackService::_make_filter(const big_int& n, const big_int& a_start) {
+    ResidueFilter filter;
+    for (unsigned m : FILTER_MODULI) {
+        std::vector<bool> square(m, false);
+        for (unsigned x = 0; x < m; ++x) {
+            square[(x * x) % m] = true;
+        }
+        const unsigned n_mod = static_cast<unsigned>(mpz_fdiv_ui(n.backend().data(), m));
+        std::vector<unsigned> bad;
+        for (unsigned c = 0; c < m; ++c) {
+            if (!square[(c * c + m - n_mod) % m]) {
+                bad.push_back(c);
+            }
+        }
+        filter.moduli.push_back(m);
+        filter.start_residues.push_back(static_cast<unsigned>(mpz_fdiv_ui(a_start.backend().data(), m)));
+        filter.bad_classes.push_back(std::move(bad));
+    }
+    return filter;
+}
+
+bool FermatAttackService::_search_window(const big_int& n, const big_int& a_start, const ResidueFilter& filter,
+                                         uint64_t first, size_t count, uint64_t& step) {
+    // skip[i] - a = a_start + first + i отсеяно по одному из модулей
+    thread_local std::vector<unsigned char> skip;
+    skip.assign(count, 0);
+    for (size_t k = 0; k < filter.moduli.size(); ++k) {
+        const unsigned m = filter.moduli[k];
+        const unsigned start = static_cast<unsigned>((filter.start_residues[k] + first % m) % m);
+        for (unsigned c : filter.bad_classes[k]) {
+            for (size_t i = (c + m - start) % m; i < count; i += m) {
+                skip[i] = 1;
+            }
+        }
+    }
+
+    // a0 и r0 = a0^2 - n в начале окна; для a0 + i: r = r0 + 2*a0*i + i^2
+    big_int a0 = a_start;
+    mpz_add_ui(a0.backend().data(), a0.backend().data(), first);
+    big_int r0 = a0 * a0 - n;
+    big_int r;
+    for (size_t i = 0; i < count; ++i) {
+        if (skip[i]) {
+            continue;
+        }
+        mpz_mul_ui(r.backend().data(), a0.backend().data(), 2 * i);
+        mpz_add(r.backend().data(), r.backend().data(), r0.backend().data());
+        mpz_add_ui(r.backend().data(), r.backend().data(), static_cast<unsigned long>(i * i));
+        if (mpz_perfect_square_p(r.backend().data())) {
+            step = first + i;
+            return true;
+        }
+    }
+    return false;
+}
+
+void FermatAttackService::_search_worker(SearchState& state) {
+    while (true) {
+        // окна раздаются по возрастанию: после найденного шага следующие окна уже не нужны
+        const uint64_t first = state.next_window.fetch_add(1) * SIEVE_WINDOW;
+        if (first >= state.max_steps || first > state.found_step.load()) {
+            return;
+        }
+        const size_t count = static_cast<size_t>(std::min<uint64_t>(SIEVE_WINDOW, state.max_steps - first));
+        uint64_t step;
+        if (_search_window(*state.n, *state.a_start, *state.filter, first, count, step)) {
+            uint64_t current = state.found_step.load();
+            while (step < current && !state.found_step.compare_exchange_weak(current, step)) {
+            }
+            return;
+        }
+    }
+}
+
+FermatAttackResult FermatAttackService::_make_result(const RsaPublicKey& publicKey, const big_int& a_start,
+                                                     uint64_t step) {
+    FermatAttackResult result{false, 0, 0, 0, 0, step};
+    big_int a = a_start;
+    mpz_add_ui(a.backend().data(), a.backend().data(), step);
+    const big_int b_square = a * a - publicKey.n;
+    big_int b;
+    mpz_sqrt(b.backend().data(), b_square.backend().data());
+    result.p = a - b;
+    result.q = a + b;
+    if (result.p == 1) {
+        return result; // тривиальное разложение n = 1 * n
+    }
+    result.success = true;
+    result.found_phi = (result.p - 1) * (result.q - 1);
+    mpz_invert(result.found_d.backend().data(), publicKey.e.backend().data(), result.found_phi.backend().data());
+    return result;
+}
+
+FermatAttackResult FermatAttackService::Attack(const RsaPublicKey& publicKey, uint64_t max_steps, unsigned threads) {
+    const big_int& n = publicKey.n;
+    // модуль RSA нечетен; для четного n разность квадратов не работает
+    if (n < 3 || mpz_even_p(n.backend().data())) {
+        return FermatAttackResult{false, 0, 0, 0, 0, 0};
+    }
+    const big_int a_start = ceil_sqrt(n);
+    const ResidueFilter filter = _make_filter(n, a_start);
+
+    SearchState state;
+    state.n = &n;
+    state.a_start = &a_start;
+    state.filter = &filter;
+    state.max_steps = max_steps;
+    state.found_step = UINT64_MAX;
+
+    const uint64_t windows = (max_steps + SIEVE_WINDOW - 1) / SIEVE_WINDOW;
+    const size_t num_threads = std::min<uint64_t>(threads ? threads : std::max(1u, std::thread::hardware_concurrency()),
+                                                  std::max<uint64_t>(windows, 1));
+    std::vector<std::future<void>> futures;
+    for (size_t i = 1; i < num_threads; ++i) {
+        futures.push_back(std::async(std::launch::async, &FermatAttackService::_search_worker, std::ref(state)));
+    }
+    _search_worker(state);
+    for (auto& fut : futures) {
+        fut.get();
+    }
+
+    const uint64_t step = state.found_step.load();
+    if (step == UINT64_MAX) {
+        return FermatAttackResult{false, 0, 0, 0, 0, max_steps};
+    }
+    return _make_result(publicKey, a_start, step);
+}
+
+std::vector<FermatScanHit> FermatAttackService::_scan_batch(const std::vector<RsaPublicKey>& keys, size_t first_index,
+                                                            uint64_t max_steps, unsigned threads) {
+    const size_t num_threads = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+    const size_t chunk_size = (keys.size() + num_threads - 1) / num_threads;
+    std::vector<FermatScanHit> hits;
+    if (chunk_size == 0) {
+        return hits;
+    }
+
+    // каждый ключ перебирается в одном потоке, параллельность - по ключам
+    auto scan_range = [&keys, first_index, max_steps](size_t begin, size_t end, std::vector<FermatScanHit>& found) {
+        for (size_t i = begin; i < end; ++i) {
+            FermatAttackResult result = Attack(keys[i], max_steps, 1);
+            if (result.success) {
+                found.push_back({first_index + i, keys[i], std::move(result)});
+            }
+        }
+    };
+    std::vector<std::vector<FermatScanHit>> partial((keys.size() + chunk_size - 1) / chunk_size);
+    std::vector<std::future<void>> futures;
+    for (size_t part = 1; part < partial.size(); ++part) {
+        const size_t begin = part * chunk_size;
+        const size_t end = std::min(begin + chunk_size, keys.size());
+        futures.push_back(std::async(std::launch::async, scan_range, begin, end, std::ref(partial[part])));
+    }
+    scan_range(0, std::min(chunk_size, keys.size()), partial[0]);
+    for (auto& fut : futures) {
+        fut.get();
+    }
+    for (auto& part : partial) {
+        std::move(part.begin(), part.end(), std::back_inserter(hits));
+    }
+    return hits;
+}
+
+std::vector<FermatScanHit> FermatAttackService::Scan(const std::vector<RsaPublicKey>& keys, uint64_t max_steps,
+                                                     unsigned threads) {
+    return _scan_batch(keys, 0, max_steps, threads);
+}
+
+std::vector<FermatScanHit> FermatAttackService::Scan(std::istream& input, uint64_t max_steps, unsigned threads) {
+    std::vector<FermatScanHit> hits;
+    std::vector<RsaPublicKey> batch;
+    size_t line_number = 0;
+    size_t first_index = 0;
+    while (ReadPublicKeys(input, batch, SCAN_BATCH_SIZE, line_number)) {
+        std::vector<FermatScanHit> found = _scan_batch(batch, first_index, max_steps, threads);
+        std::move(found.begin(), found.end(), std::back_inserter(hits));
+        first_index += batch.size();
+    }
+    return hits;
+}
@@ -0,0 +1,101 @@
+#ifndef FERMAT_ATTACK_SERVICE_H
+#define FERMAT_ATTACK_SERVICE_H
+
+#include "RsaService.h" // Нужен для RsaPublicKey
+#include <atomic>
+#include <cstdint>
+#include <istream>
+#include <vector>
+
+// Структура для хранения результатов атаки
+struct FermatAttackResult {
+    bool success;                   // Успешна ли была атака
+    big_int p;                      // Найденные множители n, p <= q
+    big_int q;
+    big_int found_d;                // Секретная экспонента d = e^-1 mod phi(n)
+    big_int found_phi;              // phi(n)
+    uint64_t steps;                 // a - ceil(sqrt(n)) для найденного a (число шагов перебора)
+};
+
+// Найденный при пакетной проверке уязвимый ключ
+struct FermatScanHit {
+    size_t index;                   // номер ключа во входных данных (с нуля)
+    RsaPublicKey key;
+    FermatAttackResult result;
+};
+
+/**
+ * @class FermatAttackService
+ * @brief Факторизация Ферма: n = a^2 - b^2 = (a - b)(a + b), перебор a от ceil(sqrt(n)).
+ *        Для p и q одной длины нужно около (p - q)^2 / (8 sqrt(n)) шагов, поэтому ключ с
+ *        |p - q| < n^(1/4) раскладывается на первом шаге - это порог, по которому
+ *        KeyGenerator::Generate отвергает ключи.
+ *        Перебор идет окнами: a, при которых a^2 - n не квадрат по малым модулям, вычеркиваются
+ *        решетом; для остальных a^2 - n получается из значения в начале окна без возведения в квадрат.
+ */
+class FermatAttackService {
+public:
+    FermatAttackService() = delete; // Stateless-сервис
+
+    static constexpr uint64_t DEFAULT_MAX_STEPS = uint64_t(1) << 24;
+
+    /**
+     * @brief Выполняет атаку на открытый ключ RSA.
+     * @param max_steps Сколько значений a проверить.
+     * @param threads Потоки (0 - по числу ядер): окна раздаются потокам по порядку, результат
+     *        не зависит от их числа.
+     */
+    static FermatAttackResult Attack(const RsaPublicKey& publicKey, uint64_t max_steps = DEFAULT_MAX_STEPS,
+                                     unsigned threads = 0);
+
+    /**
+     * @brief Пакетная проверка: ключи делятся между потоками, возвращаются только разложенные,
+     *        в порядке исходных индексов.
+     */
+    static std::vector<FermatScanHit> Scan(const std::vector<RsaPublicKey>& keys,
+                                           uint64_t max_steps = DEFAULT_MAX_STEPS, unsigned threads = 0);
+    /**
+     * @brief Пакетная проверка ключей из потока в формате WienerAttackService::Scan ("n e" на строку).
+     * @throws std::invalid_argument при некорректной строке (с ее номером).
+     */
+    static std::vector<FermatScanHit> Scan(std::istream& input, uint64_t max_steps = DEFAULT_MAX_STEPS,
+                                           unsigned threads = 0);
+
+    /**
+     * @brief Число шагов, за которое атака разложит n = p * q (p, q нечетны): (p + q) / 2 - ceil(sqrt(n)).
+     *        Позволяет проверить порог генератора ключей без самого перебора.
+     */
+    static big_int StepsToFactor(const big_int& p, const big_int& q);
+
+private:
+    static constexpr size_t SIEVE_WINDOW = 8192;
+    static constexpr size_t SCAN_BATCH_SIZE = 4096;
+
+    // Классы a по малым модулям, при которых a^2 - n не может быть квадратом
+    struct ResidueFilter {
+        std::vector<unsigned> moduli;
+        std::vector<unsigned> start_residues;           // ceil(sqrt(n)) mod m
+        std::vector<std::vector<unsigned>> bad_classes; // a mod m
+    };
+
+    // Общее состояние потоков, перебирающих окна одного ключа
+    struct SearchState {
+        const big_int* n;
+        const big_int* a_start;     // ceil(sqrt(n))
+        const ResidueFilter* filter;
+        uint64_t max_steps;
+        std::atomic<uint64_t> next_window{0};
+        std::atomic<uint64_t> found_step; // наименьший найденный шаг, UINT64_MAX - не найден
+    };
+
+    static ResidueFilter _make_filter(const big_int& n, const big_int& a_start);
+    static void _search_worker(SearchState& state);
+    // Первый шаг окна [first, first + count), при котором a^2 - n - полный квадрат
+    static bool _search_window(const big_int& n, const big_int& a_start, const ResidueFilter& filter,
+                               uint64_t first, size_t count, uint64_t& step);
+    static FermatAttackResult _make_result(const RsaPublicKey& publicKey, const big_int& a_start, uint64_t step);
+    static std::vector<FermatScanHit> _scan_batch(const std::vector<RsaPublicKey>& keys, size_t first_index,
+                                                  uint64_t max_steps, unsigned threads);
+};
+
+#endif //FERMAT_ATTACK_SERVICE_H
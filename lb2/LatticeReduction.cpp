@@ -0,0 +1,291 @@
+#include "LatticeReduction.h"
+#include "ParallelFor.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+    using Matrix = std::vector<std::vector<big_int>>;
+
+    // Старшие 64 бита числа в long double (15-битный порядок long double вмещает любые наши длины);
+    // читаются прямо из лимбов, без временных mpz
+    long double to_long_double(const big_int& value) {
+        const mpz_srcptr z = value.backend().data();
+        const size_t size = mpz_size(z);
+        if (size == 0) {
+            return 0.0L;
+        }
+        const mp_limb_t high = mpz_getlimbn(z, static_cast<mp_size_t>(size - 1));
+        long double result;
+        if (size == 1) {
+            result = static_cast<long double>(high);
+        } else {
+            const mp_limb_t low = mpz_getlimbn(z, static_cast<mp_size_t>(size - 2));
+            const int shift = __builtin_clzll(high);
+            const mp_limb_t top = shift ? (high << shift) | (low >> (64 - shift)) : high;
+            result = std::ldexp(static_cast<long double>(top), static_cast<int>(64 * (size - 1)) - shift);
+        }
+        return mpz_sgn(z) < 0 ? -result : result;
+    }
+
+    // Точное целое значение уже округленного long double
+    big_int to_big_int(long double value) {
+        if (std::fabs(value) < 9.2e18L) {
+            return big_int(static_cast<long long>(value));
+        }
+        int exponent;
+        const long double mantissa = std::frexp(std::fabs(value), &exponent);
+        big_int result(static_cast<unsigned long long>(std::ldexp(mantissa, 64)));
+        if (exponent >= 64) {
+            result <<= exponent - 64;
+        } else {
+            result >>= 64 - exponent;
+        }
+        return value < 0 ? big_int(-result) : result;
+    }
+
+    void dot(const std::vector<big_int>& a, const std::vector<big_int>& b, big_int& out) {
+        mpz_ptr r = out.backend().data();
+        mpz_set_ui(r, 0);
+        for (size_t i = 0; i < a.size(); ++i) {
+            mpz_addmul(r, a[i].backend().data(), b[i].backend().data());
+        }
+    }
+
+    // a -= q * b
+    void sub_multiple(std::vector<big_int>& a, const big_int& q, const std::vector<big_int>& b) {
+        for (size_t i = 0; i < a.size(); ++i) {
+            mpz_submul(a[i].backend().data(), q.backend().data(), b[i].backend().data());
+        }
+    }
+
+    // Обновление строки матрицы Грама - по одному умножению на элемент: потоки окупаются только на
+    // длинных строках
+    constexpr size_t GRAM_UPDATE_GRAIN = 64;
+
+    unsigned thread_count(const LatticeReduction::Options& options) {
+        return options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    void validate(const Matrix& basis, const LatticeReduction::Options& options) {
+        if (basis.empty() || basis[0].empty()) {
+            throw std::invalid_argument("Базис решетки пуст");
+        }
+        for (const auto& row : basis) {
+            if (row.size() != basis[0].size()) {
+                throw std::invalid_argument("Векторы базиса должны быть одной длины");
+            }
+        }
+        if (!(options.delta > 0.25 && options.delta < 1.0)) {
+            throw std::invalid_argument("delta должно быть в интервале (0.25, 1)");
+        }
+    }
+}
+
+LatticeReduction::Stats LatticeReduction::Reduce(std::vector<std::vector<big_int>>& basis) {
+    return Reduce(basis, Options());
+}
+
+LatticeReduction::Stats LatticeReduction::Reduce(std::vector<std::vector<big_int>>& basis, const Options& options) {
+    validate(basis, options);
+    Stats stats;
+    if (!_reduce_floating(basis, options, stats)) {
+        Stats exact = ReduceExact(basis, options);
+        stats.swaps += exact.swaps;
+        stats.size_reductions += exact.size_reductions;
+        stats.exact_fallback = true;
+    }
+    return stats;
+}
+
+bool LatticeReduction::_reduce_floating(std::vector<std::vector<big_int>>& basis, const Options& options, Stats& stats) {
+    const size_t d = basis.size();
+    const unsigned threads = thread_count(options);
+    // допуск на |mu| после редукции (L^2: eta > 1/2 из-за погрешности)
+    const long double eta = 0.51L;
+    // За один проход редукции |mu| уменьшается примерно на 60 бит (точность long double), поэтому
+    // длинным векторам нужно несколько проходов; без уменьшения max|mu| несколько раз подряд -
+    // арифметика не справляется
+    const size_t max_stalled_rounds = 4;
+
+    // Точная матрица Грама, строки считаются параллельно
+    Matrix gram(d, std::vector<big_int>(d));
+    parallel_for(0, d, threads, 2, [&](size_t i) {
+        for (size_t j = 0; j <= i; ++j) {
+            dot(basis[i], basis[j], gram[i][j]);
+        }
+    });
+    for (size_t i = 0; i < d; ++i) {
+        for (size_t j = i + 1; j < d; ++j) {
+            gram[i][j] = gram[j][i];
+        }
+    }
+
+    std::vector<std::vector<long double>> mu(d, std::vector<long double>(d, 0.0L));
+    std::vector<std::vector<long double>> r(d, std::vector<long double>(d, 0.0L));
+    r[0][0] = to_long_double(gram[0][0]);
+
+    size_t k = 1;
+    while (k < d) {
+        long double previous_max = INFINITY;
+        for (size_t stalled = 0;;) {
+            // строка k ортогонализации Грама-Шмидта по точным скалярным произведениям
+            long double max_mu = 0.0L;
+            for (size_t j = 0; j < k; ++j) {
+                long double value = to_long_double(gram[k][j]);
+                for (size_t i = 0; i < j; ++i) {
+                    value -= mu[j][i] * r[k][i];
+                }
+                r[k][j] = value;
+                mu[k][j] = value / r[j][j];
+                max_mu = std::max(max_mu, std::fabs(mu[k][j]));
+            }
+            if (max_mu <= eta) {
+                break;
+            }
+            if (!std::isfinite(max_mu) || (max_mu >= previous_max && ++stalled > max_stalled_rounds)) {
+                return false;
+            }
+            previous_max = max_mu;
+
+            big_int q;
+            for (size_t j = k; j-- > 0;) {
+                const long double x = std::round(mu[k][j]);
+                if (x == 0.0L) {
+                    continue;
+                }
+                q = to_big_int(x);
+                sub_multiple(basis[k], q, basis[j]);
+                // строка k матрицы Грама обновляется без пересчета скалярных произведений:
+                // <b_k - q b_j, b_i> = G_ki - q G_ji,  |b_k - q b_j|^2 = G_kk - 2q G_kj + q^2 G_jj
+                mpz_ptr g_kk = gram[k][k].backend().data();
+                mpz_submul(g_kk, q.backend().data(), gram[k][j].backend().data());
+                mpz_submul(g_kk, q.backend().data(), gram[k][j].backend().data());
+                big_int q_square = q * q;
+                mpz_addmul(g_kk, q_square.backend().data(), gram[j][j].backend().data());
+                parallel_for(0, d, threads, GRAM_UPDATE_GRAIN, [&](size_t i) {
+                    if (i != k) {
+                        mpz_submul(gram[k][i].backend().data(), q.backend().data(), gram[j][i].backend().data());
+                    }
+                });
+                for (size_t i = 0; i < j; ++i) {
+                    mu[k][i] -= x * mu[j][i];
+                }
+                mu[k][j] -= x;
+                ++stats.size_reductions;
+            }
+            for (size_t i = 0; i < d; ++i) {
+                gram[i][k] = gram[k][i];
+            }
+        }
+
+        // Условие Ловаса в форме L^2: s = |b_k|^2 - sum_{j<k-1} mu_kj r_kj = r_kk + mu_k,k-1^2 r_k-1,k-1
+        // считается без вычитания близких величин r_kk; отрицательное s из-за погрешности - тоже обмен
+        long double s = to_long_double(gram[k][k]);
+        for (size_t j = 0; j + 1 < k; ++j) {
+            s -= mu[k][j] * r[k][j];
+        }
+        if (!std::isfinite(s)) {
+            return false;
+        }
+
+        if (static_cast<long double>(options.delta) * r[k - 1][k - 1] > s) {
+            std::swap(basis[k], basis[k - 1]);
+            std::swap(gram[k], gram[k - 1]);
+            for (size_t i = 0; i < d; ++i) {
+                std::swap(gram[i][k], gram[i][k - 1]);
+            }
+            ++stats.swaps;
+            k = std::max<size_t>(k - 1, 1);
+            if (k == 1) {
+                r[0][0] = to_long_double(gram[0][0]);
+            }
+        } else {
+            r[k][k] = s - mu[k][k - 1] * r[k][k - 1];
+            ++k;
+        }
+    }
+    return true;
+}
+
+LatticeReduction::Stats LatticeReduction::ReduceExact(std::vector<std::vector<big_int>>& basis, const Options& options) {
+    validate(basis, options);
+    const size_t n = basis.size();
+    const unsigned threads = thread_count(options);
+    Stats stats;
+
+    // delta как дробь delta_num / delta_den
+    const long delta_den = 1000000;
+    const long delta_num = std::lround(options.delta * delta_den);
+
+    // dd[i + 1] = d_i (dd[0] = d_-1 = 1), lambda[k][j] - целые коэффициенты Грама-Шмидта
+    std::vector<big_int> dd(n + 1);
+    Matrix lambda(n);
+    for (auto& row : lambda) {
+        row.resize(n);
+    }
+    dd[0] = 1;
+    big_int u;
+    for (size_t k = 0; k < n; ++k) {
+        for (size_t j = 0; j <= k; ++j) {
+            dot(basis[k], basis[j], u);
+            for (size_t i = 0; i < j; ++i) {
+                u = (dd[i + 1] * u - lambda[k][i] * lambda[j][i]) / dd[i];
+            }
+            if (j < k) {
+                lambda[k][j] = u;
+            } else {
+                dd[k + 1] = u;
+            }
+        }
+        if (dd[k + 1] == 0) {
+            throw std::invalid_argument("Векторы базиса линейно зависимы");
+        }
+    }
+
+    auto reduce = [&](size_t k, size_t l) {
+        const big_int& d_l = dd[l + 1];
+        if (2 * boost::multiprecision::abs(lambda[k][l]) <= d_l) {
+            return;
+        }
+        // q - ближайшее целое к lambda / d_l
+        big_int q = (2 * lambda[k][l] + d_l);
+        mpz_fdiv_q(q.backend().data(), q.backend().data(), big_int(2 * d_l).backend().data());
+        sub_multiple(basis[k], q, basis[l]);
+        lambda[k][l] -= q * d_l;
+        for (size_t i = 0; i < l; ++i) {
+            lambda[k][i] -= q * lambda[l][i];
+        }
+        ++stats.size_reductions;
+    };
+
+    size_t k = 1;
+    while (k < n) {
+        reduce(k, k - 1);
+        const big_int& lam = lambda[k][k - 1];
+        if (delta_den * dd[k + 1] * dd[k - 1] < delta_num * dd[k] * dd[k] - delta_den * lam * lam) {
+            // SWAP(k)
+            std::swap(basis[k], basis[k - 1]);
+            for (size_t j = 0; j + 1 < k; ++j) {
+                std::swap(lambda[k][j], lambda[k - 1][j]);
+            }
+            const big_int l = lambda[k][k - 1];
+            const big_int b = (dd[k - 1] * dd[k + 1] + l * l) / dd[k];
+            parallel_for(k + 1, n, threads, 8, [&](size_t i) {
+                const big_int t = lambda[i][k];
+                lambda[i][k] = (dd[k + 1] * lambda[i][k - 1] - l * t) / dd[k];
+                lambda[i][k - 1] = (b * t + l * lambda[i][k]) / dd[k + 1];
+            });
+            dd[k] = b;
+            ++stats.swaps;
+            k = std::max<size_t>(k - 1, 1);
+        } else {
+            for (size_t l = k - 1; l-- > 0;) {
+                reduce(k, l);
+            }
+            ++k;
+        }
+    }
+    return stats;
+}
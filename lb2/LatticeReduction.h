@@ -0,0 +1,50 @@
+#ifndef CRYPTOGRAPHY_LATTICEREDUCTION_H
+#define CRYPTOGRAPHY_LATTICEREDUCTION_H
+
+#include <boost/multiprecision/gmp.hpp>
+#include <cstddef>
+#include <vector>
+
+using big_int = boost::multiprecision::mpz_int;
+
+/**
+ * @class LatticeReduction
+ * @brief LLL-редукция целочисленного базиса (строки матрицы - векторы базиса).
+ *        Основной путь - LLL с ортогонализацией Грама-Шмидта в long double над точной матрицей Грама
+ *        (в духе L^2 Нгуена-Стеле): базис и скалярные произведения считаются точно, в плавающей
+ *        точке - только коэффициенты mu и квадраты длин. Матрица Грама считается параллельно по строкам,
+ *        после редукции вектора его строка обновляется точно (на длинных строках - в несколько потоков).
+ *        Если плавающая арифметика перестает сходиться, редукция продолжается точным целочисленным
+ *        LLL (Cohen, алгоритм 2.6.7), в котором обновление коэффициентов при обмене тоже параллельно.
+ */
+class LatticeReduction {
+public:
+    LatticeReduction() = delete; // Stateless-сервис
+
+    struct Options {
+        double delta = 0.99;   // параметр условия Ловаса
+        unsigned threads = 0;  // 0 - по числу ядер
+    };
+
+    struct Stats {
+        size_t swaps = 0;
+        size_t size_reductions = 0;
+        bool exact_fallback = false;  // пришлось ли переключиться на точный LLL
+    };
+
+    /**
+     * @param basis Линейно независимые векторы одинаковой длины; заменяется LLL-приведенным базисом.
+     * @throws std::invalid_argument при пустом базисе, разной длине векторов или delta вне (0.25, 1).
+     */
+    static Stats Reduce(std::vector<std::vector<big_int>>& basis, const Options& options);
+    static Stats Reduce(std::vector<std::vector<big_int>>& basis);
+
+    /** @brief Точный целочисленный LLL без плавающей точки. */
+    static Stats ReduceExact(std::vector<std::vector<big_int>>& basis, const Options& options);
+
+private:
+    // false - плавающая арифметика не справилась, базис оставлен в согласованном (частично приведенном) виде
+    static bool _reduce_floating(std::vector<std::vector<big_int>>& basis, const Options& options, Stats& stats);
+};
+
+#endif //CRYPTOGRAPHY_LATTICEREDUCTION_H
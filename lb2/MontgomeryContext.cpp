@@ -0,0 +1,255 @@
+#include "MontgomeryContext.h"
+#include <stdexcept>
+#include <algorithm>
+
+namespace {
+    unsigned window_size(unsigned bits) {
+        if (bits > 671) return 6;
+        if (bits > 239) return 5;
+        if (bits > 79) return 4;
+        if (bits > 23) return 3;
+        return 1;
+    }
+}
+
+MontgomeryContext::MontgomeryContext(const big_int& n) : _n(n) {
+    if (n <= 1 || mpz_even_p(n.backend().data())) {
+        throw std::invalid_argument("Модуль Монтгомери должен быть нечетным и больше 1");
+    }
+    _k = static_cast<mp_size_t>(mpz_size(n.backend().data()));
+    _n_limbs.assign(mpz_limbs_read(n.backend().data()), mpz_limbs_read(n.backend().data()) + _k);
+
+    // n0^-1 mod 2^64 по Ньютону: каждая итерация удваивает число верных бит
+    mp_limb_t inv = _n_limbs[0];
+    for (int i = 0; i < 6; ++i) {
+        inv *= 2 - _n_limbs[0] * inv;
+    }
+    _n_prime = -inv;
+
+    const big_int r = big_int(1) << (GMP_NUMB_BITS * _k);
+    _r_mod_n = r % n;
+    _r2_mod_n = (_r_mod_n * _r_mod_n) % n;
+}
+
+MontgomeryContext::limb_vector MontgomeryContext::_to_limbs(const big_int& a) const {
+    limb_vector limbs(_k, 0);
+    const mpz_srcptr z = a.backend().data();
+    const size_t size = mpz_size(z);
+    const mp_limb_t* src = mpz_limbs_read(z);
+    for (size_t i = 0; i < size && i < static_cast<size_t>(_k); ++i) {
+        limbs[i] = src[i];
+    }
+    return limbs;
+}
+
+big_int MontgomeryContext::_from_limbs(const mp_limb_t* limbs) const {
+    big_int result;
+    mpz_ptr z = result.backend().data();
+    mp_limb_t* dst = mpz_limbs_write(z, _k);
+    for (mp_size_t i = 0; i < _k; ++i) {
+        dst[i] = limbs[i];
+    }
+    mpz_limbs_finish(z, _k);
+    return result;
+}
+
+void MontgomeryContext::_redc(mp_limb_t* t, mp_limb_t* out) const {
+    // t[2k] - лимб переполнения
+    for (mp_size_t i = 0; i < _k; ++i) {
+        const mp_limb_t m = t[i] * _n_prime;
+        const mp_limb_t carry = mpn_addmul_1(t + i, _n_limbs.data(), _k, m);
+        mpn_add_1(t + i + _k, t + i + _k, _k + 1 - i, carry);
+    }
+    if (t[2 * _k] != 0 || mpn_cmp(t + _k, _n_limbs.data(), _k) >= 0) {
+        mpn_sub_n(out, t + _k, _n_limbs.data(), _k);
+    } else {
+        mpn_copyi(out, t + _k, _k);
+    }
+}
+
+void MontgomeryContext::_mul(const mp_limb_t* a, const mp_limb_t* b, mp_limb_t* out, mp_limb_t* scratch) const {
+    mpn_mul_n(scratch, a, b, _k);
+    scratch[2 * _k] = 0;
+    _redc(scratch, out);
+}
+
+void MontgomeryContext::_sqr(const mp_limb_t* a, mp_limb_t* out, mp_limb_t* scratch) const {
+    mpn_sqr(scratch, a, _k);
+    scratch[2 * _k] = 0;
+    _redc(scratch, out);
+}
+
+big_int MontgomeryContext::ToMontgomery(const big_int& a) const {
+    big_int reduced = a % _n;
+    if (reduced < 0) {
+        reduced += _n;
+    }
+    return Multiply(reduced, _r2_mod_n);
+}
+
+big_int MontgomeryContext::FromMontgomery(const big_int& a) const {
+    limb_vector t(2 * _k + 1, 0);
+    const limb_vector limbs = _to_limbs(a);
+    mpn_copyi(t.data(), limbs.data(), _k);
+    limb_vector out(_k);
+    _redc(t.data(), out.data());
+    return _from_limbs(out.data());
+}
+
+big_int MontgomeryContext::Multiply(const big_int& a, const big_int& b) const {
+    const limb_vector la = _to_limbs(a);
+    const limb_vector lb = _to_limbs(b);
+    limb_vector scratch(2 * _k + 1);
+    limb_vector out(_k);
+    _mul(la.data(), lb.data(), out.data(), scratch.data());
+    return _from_limbs(out.data());
+}
+
+big_int MontgomeryContext::Square(const big_int& a) const {
+    const limb_vector la = _to_limbs(a);
+    limb_vector scratch(2 * _k + 1);
+    limb_vector out(_k);
+    _sqr(la.data(), out.data(), scratch.data());
+    return _from_limbs(out.data());
+}
+
+void MontgomeryContext::_pow(limb_vector& result, const limb_vector& base, const ExponentChain& chain) const {
+    result = _to_limbs(_r_mod_n);
+    if (chain._steps.empty()) {
+        return;
+    }
+    limb_vector scratch(2 * _k + 1);
+    limb_vector tmp(_k);
+
+    // odd_powers[i] = base^(2i+1)
+    std::vector<limb_vector> odd_powers(chain._table_size, limb_vector(_k));
+    odd_powers[0] = base;
+    if (odd_powers.size() > 1) {
+        limb_vector base_sq(_k);
+        _sqr(base.data(), base_sq.data(), scratch.data());
+        for (std::size_t i = 1; i < odd_powers.size(); ++i) {
+            _mul(odd_powers[i - 1].data(), base_sq.data(), odd_powers[i].data(), scratch.data());
+        }
+    }
+
+    result = odd_powers[chain._steps.front().table_index];
+    for (std::size_t s = 1; s < chain._steps.size(); ++s) {
+        const ExponentChain::Step& step = chain._steps[s];
+        for (unsigned t = 0; t < step.squarings; ++t) {
+            _sqr(result.data(), tmp.data(), scratch.data());
+            result.swap(tmp);
+        }
+        if (step.table_index >= 0) {
+            _mul(result.data(), odd_powers[step.table_index].data(), tmp.data(), scratch.data());
+            result.swap(tmp);
+        }
+    }
+}
+
+big_int MontgomeryContext::PowMontgomery(const big_int& base, const big_int& exp) const {
+    if (exp < 0) {
+        throw std::invalid_argument("Степень не может быть отрицательной");
+    }
+    limb_vector result;
+    _pow(result, _to_limbs(base), ExponentChain(exp));
+    return _from_limbs(result.data());
+}
+
+big_int MontgomeryContext::Pow(const big_int& base, const big_int& exp) const {
+    return FromMontgomery(PowMontgomery(ToMontgomery(base), exp));
+}
+
+big_int MontgomeryContext::Pow(const big_int& base, const ExponentChain& chain) const {
+    if (!chain._fermat) {
+        limb_vector result;
+        _pow(result, _to_limbs(ToMontgomery(base)), chain);
+        return FromMontgomery(_from_limbs(result.data()));
+    }
+
+    // b^(2^k + 1): k квадратов над bR, затем умножение Монтгомери на b в обычной форме
+    // сразу дает результат в обычной форме, без отдельного FromMontgomery
+    big_int reduced = base % _n;
+    if (reduced < 0) {
+        reduced += _n;
+    }
+    const limb_vector plain = _to_limbs(reduced);
+    limb_vector x = _to_limbs(ToMontgomery(reduced));
+    limb_vector tmp(_k);
+    limb_vector scratch(2 * _k + 1);
+    for (unsigned i = 0; i < chain._fermat_power; ++i) {
+        _sqr(x.data(), tmp.data(), scratch.data());
+        x.swap(tmp);
+    }
+    _mul(x.data(), plain.data(), tmp.data(), scratch.data());
+    return _from_limbs(tmp.data());
+}
+
+bool MontgomeryContext::StrongProbablePrime(const big_int& base, const ExponentChain& d_chain, unsigned s) const {
+    limb_vector x;
+    _pow(x, _to_limbs(ToMontgomery(base)), d_chain);
+    // 1 и -1 в форме Монтгомери: R mod n и n - (R mod n)
+    const limb_vector one = _to_limbs(_r_mod_n);
+    const limb_vector minus_one = _to_limbs(_n - _r_mod_n);
+    if (x == one || x == minus_one) {
+        return true;
+    }
+    limb_vector tmp(_k);
+    limb_vector scratch(2 * _k + 1);
+    for (unsigned r = 1; r < s; ++r) {
+        _sqr(x.data(), tmp.data(), scratch.data());
+        x.swap(tmp);
+        if (x == minus_one) {
+            return true;
+        }
+        // нетривиальный квадратный корень из 1 - дальше -1 уже не появится
+        if (x == one) {
+            return false;
+        }
+    }
+    return false;
+}
+
+ExponentChain::ExponentChain(const big_int& exp) : _exp(exp) {
+    if (exp < 0) {
+        throw std::invalid_argument("Степень не может быть отрицательной");
+    }
+    if (exp.is_zero()) {
+        return;
+    }
+    const unsigned bits = boost::multiprecision::msb(exp) + 1;
+    const mpz_srcptr e = exp.backend().data();
+
+    // 2^k + 1: старший бит k, младший бит 0 и больше ни одного
+    if (bits > 1 && mpz_popcount(e) == 2 && mpz_tstbit(e, 0)) {
+        _fermat = true;
+        _fermat_power = bits - 1;
+    }
+
+    const unsigned w = window_size(bits);
+    _table_size = std::size_t(1) << (w - 1);
+    unsigned pending = 0;
+    long i = static_cast<long>(bits) - 1;
+    while (i >= 0) {
+        if (!mpz_tstbit(e, i)) {
+            ++pending;
+            --i;
+            continue;
+        }
+        // окно [j, i] длиной не больше w, заканчивающееся единичным битом
+        long j = std::max(i - static_cast<long>(w) + 1, 0L);
+        while (!mpz_tstbit(e, j)) {
+            ++j;
+        }
+        unsigned value = 0;
+        for (long t = i; t >= j; --t) {
+            value = (value << 1) | static_cast<unsigned>(mpz_tstbit(e, t));
+        }
+        const unsigned squarings = _steps.empty() ? 0 : pending + static_cast<unsigned>(i - j + 1);
+        _steps.push_back({squarings, static_cast<int>(value >> 1)});
+        pending = 0;
+        i = j - 1;
+    }
+    if (pending > 0) {
+        _steps.push_back({pending, -1});
+    }
+}
@@ -0,0 +1,98 @@
+#ifndef CRYPTOGRAPHY_MONTGOMERYCONTEXT_H
+#define CRYPTOGRAPHY_MONTGOMERYCONTEXT_H
+
+#include <boost/multiprecision/gmp.hpp>
+#include <vector>
+
+using big_int = boost::multiprecision::mpz_int;
+
+/**
+ * @class ExponentChain
+ * @brief Заранее разобранный показатель степени для многократного возведения разных оснований
+ *        в одну и ту же степень (например, открытая экспонента RSA).
+ *        Показатели вида 2^k + 1 (3, 17, 257, 65537) распознаются отдельно: для них выполняется
+ *        ровно k возведений в квадрат и одно умножение. Остальные раскладываются в цепочку
+ *        скользящего окна, которая строится один раз.
+ */
+class ExponentChain {
+public:
+    explicit ExponentChain(const big_int& exp);
+
+    bool IsFermat() const { return _fermat; }
+    const big_int& Exponent() const { return _exp; }
+
+private:
+    friend class MontgomeryContext;
+
+    struct Step {
+        unsigned squarings;
+        int table_index; // -1 - только возведения в квадрат
+    };
+
+    big_int _exp;
+    bool _fermat = false;
+    unsigned _fermat_power = 0;
+    size_t _table_size = 0;
+    std::vector<Step> _steps;
+};
+
+/**
+ * @class MontgomeryContext
+ * @brief Арифметика Монтгомери для многократных операций по одному нечетному модулю n.
+ *        R = 2^(64*k), где k - число лимбов n; R mod n, R^2 mod n и n' = -n^-1 mod 2^64
+ *        считаются один раз в конструкторе, после чего умножение обходится без деления.
+ *        Объект неизменяем и может использоваться из нескольких потоков.
+ */
+class MontgomeryContext {
+public:
+    /**
+     * @param n Нечетный модуль, n > 1.
+     */
+    explicit MontgomeryContext(const big_int& n);
+
+    /** @brief a -> a*R mod n. */
+    big_int ToMontgomery(const big_int& a) const;
+    /** @brief a*R -> a mod n. */
+    big_int FromMontgomery(const big_int& a) const;
+    /** @brief Произведение Монтгомери a*b*R^-1 mod n (аргументы в форме Монтгомери). */
+    big_int Multiply(const big_int& a, const big_int& b) const;
+    /** @brief Квадрат Монтгомери a*a*R^-1 mod n. */
+    big_int Square(const big_int& a) const;
+    /** @brief base^exp в форме Монтгомери (base - в форме Монтгомери). */
+    big_int PowMontgomery(const big_int& base, const big_int& exp) const;
+    /** @brief Обычное base^exp mod n (вход и выход - в обычной форме). */
+    big_int Pow(const big_int& base, const big_int& exp) const;
+    /** @brief Обычное base^exp mod n по заранее построенной цепочке. */
+    big_int Pow(const big_int& base, const ExponentChain& chain) const;
+
+    /**
+     * @brief Сильная проверка на вероятную простоту n по основанию base, где n - 1 = d * 2^s.
+     *        Показатель d разобран заранее и один на все основания; возведения в квадрат
+     *        выполняются на месте, без перевода промежуточных значений в big_int.
+     */
+    bool StrongProbablePrime(const big_int& base, const ExponentChain& d_chain, unsigned s) const;
+
+    const big_int& Modulus() const { return _n; }
+    /** @brief Единица в форме Монтгомери (R mod n). */
+    const big_int& One() const { return _r_mod_n; }
+
+private:
+    using limb_vector = std::vector<mp_limb_t>;
+
+    limb_vector _to_limbs(const big_int& a) const;
+    big_int _from_limbs(const mp_limb_t* limbs) const;
+    // out = t * R^-1 mod n; t - 2k+1 лимбов, портится
+    void _redc(mp_limb_t* t, mp_limb_t* out) const;
+    void _mul(const mp_limb_t* a, const mp_limb_t* b, mp_limb_t* out, mp_limb_t* scratch) const;
+    void _sqr(const mp_limb_t* a, mp_limb_t* out, mp_limb_t* scratch) const;
+    void _pow(limb_vector& result, const limb_vector& base, const ExponentChain& chain) const;
+
+    big_int _n;
+    limb_vector _n_limbs;
+    mp_size_t _k;
+    mp_limb_t _n_prime;
+    big_int _r_mod_n;
+    big_int _r2_mod_n;
+};
+
+#endif //CRYPTOGRAPHY_MONTGOMERYCONTEXT_H
@@ -0,0 +1,42 @@
+#ifndef PARALLEL_FOR_H
+#define PARALLEL_FOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <future>
+#include <vector>
+
+/**
+ * @brief Независимые итерации [begin, end) делятся на непрерывные диапазоны по потокам, не короче grain
+ *        итераций каждый; первый диапазон выполняется в вызывающем потоке, мелкие задачи - целиком в нем.
+ *        Исключение из body передается вызывающему после завершения всех диапазонов.
+ */
+template <typename Body>
+void parallel_for(size_t begin, size_t end, unsigned threads, size_t grain, Body body) {
+    const size_t count = end > begin ? end - begin : 0;
+    const size_t num_threads = std::min<size_t>(threads, count / std::max<size_t>(grain, 1));
+    if (num_threads <= 1) {
+        for (size_t i = begin; i < end; ++i) {
+            body(i);
+        }
+        return;
+    }
+    const size_t chunk = (count + num_threads - 1) / num_threads;
+    std::vector<std::future<void>> futures;
+    for (size_t start = begin + chunk; start < end; start += chunk) {
+        const size_t stop = std::min(start + chunk, end);
+        futures.push_back(std::async(std::launch::async, [&body, start, stop]() {
+            for (size_t i = start; i < stop; ++i) {
+                body(i);
+            }
+        }));
+    }
+    for (size_t i = begin; i < std::min(begin + chunk, end); ++i) {
+        body(i);
+    }
+    for (auto& fut : futures) {
+        fut.get();
+    }
+}
+
+#endif //PARALLEL_FOR_H
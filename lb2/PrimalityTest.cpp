@@ -3,10 +3,48 @@
 //
 
 #include "PrimalityTest.h"
+#include "ChaCha20Random.h"
 #include <cmath>
 #include <stdexcept>
-#include <boost/random.hpp>
-#include <chrono>
+#include <algorithm>
+#include <vector>
+
+namespace {
+    const unsigned MR_PRIME_BASES[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41};
+
+    // Для n < bound достаточно первых count простых оснований (Jaeschke; Jiang, Deng; Sorenson, Webster)
+    struct DeterministicBases {
+        const char* bound;
+        size_t count;
+    };
+    const DeterministicBases MR_DETERMINISTIC_BASES[] = {
+            {"2047", 1},
+            {"1373653", 2},
+            {"25326001", 3},
+            {"3215031751", 4},
+            {"2152302898747", 5},
+            {"3474749660383", 6},
+            {"341550071728321", 7},
+            {"3825123056546413051", 9},
+            {"318665857834031151167461", 12},
+            {"3317044064679887385961981", 13},
+    };
+
+    // n - 1 = d * 2^s сдвигом на число младших нулевых бит
+    unsigned split_power_of_two(const big_int& n_minus_one, big_int& d) {
+        const unsigned s = static_cast<unsigned>(mpz_scan1(n_minus_one.backend().data(), 0));
+        d = n_minus_one >> s;
+        return s;
+    }
+
+    // (x / 2) mod n для нечетного n
+    void half_mod(mpz_t x, const mpz_t n) {
+        if (mpz_odd_p(x)) {
+            mpz_add(x, x, n);
+        }
+        mpz_fdiv_q_2exp(x, x, 1);
+    }
+}
 
 bool PrimalityTest::IsPrime(const big_int& n, double min_probability) const {
     if (n < big_int(2)) {
@@ -25,8 +63,9 @@ bool PrimalityTest::IsPrime(const big_int& n, double min_probability) const {
 
     int k = static_cast<int>(ceil(log2(1.0 / (1.0 - min_probability))));
 
+    const MontgomeryContext ctx(n);
     for (int i = 0; i < k; ++i) {
-        if (!PerformSingleIteration(n)) {
+        if (!PerformSingleIteration(n, ctx)) {
             return false;
         }
     }
@@ -42,51 +81,187 @@ big_int PrimalityTest::GenerateRandomBigInt(const big_int& min, const big_int& m
         return min;
     }
 
-    thread_local static boost::random::mt19937_64 gen(
-            std::chrono::high_resolution_clock::now().time_since_epoch().count()
-    );
-
-    boost::random::uniform_int_distribution<big_int> dist(min, max);
-    return dist(gen);
+    return ChaCha20Random::ThreadLocal().Uniform(min, max);
 }
 
 
-bool FermatTest::PerformSingleIteration(const big_int& n) const {
+bool FermatTest::PerformSingleIteration(const big_int& n, const MontgomeryContext& ctx) const {
     big_int a = GenerateRandomBigInt(2, n - 2);
     if (CryptoService::Gcd(a, n) > 1) {
         return false;
     }
-    return CryptoService::ModPow(a, n - 1, n) == 1;
+    return ctx.PowMontgomery(ctx.ToMontgomery(a), n - 1) == ctx.One();
 }
 
-bool SolovayStrassenTest::PerformSingleIteration(const big_int& n) const {
+bool SolovayStrassenTest::PerformSingleIteration(const big_int& n, const MontgomeryContext& ctx) const {
     big_int a = GenerateRandomBigInt(2, n - 2);
     if (CryptoService::Gcd(a, n) > 1) {
         return false;
     }
     int jacobi = CryptoService::JacobiSymbol(a, n);
-    big_int mod_pow = CryptoService::ModPow(a, (n - 1) / 2, n);
+    big_int mod_pow = ctx.Pow(a, (n - 1) / 2);
     big_int jacobi_big = (jacobi == -1) ? (n - 1) : big_int(jacobi);
     return mod_pow == jacobi_big;
 }
 
-bool MillerRabinTest::PerformSingleIteration(const big_int& n) const {
-    big_int d = n - 1;
-    big_int s = 0;
-    while (d % 2 == 0) {
-        d /= 2;
-        s++;
+int MillerRabinTest::RoundCount(unsigned bits, double min_probability) {
+    // FIPS 186-5, приложение B.3: раунды M-R для вероятных простых заданной длины (случайные кандидаты)
+    if (bits >= 1536) return 4;
+    if (bits >= 1024) return 5;
+    if (bits >= 512) return 7;
+    // меньшие длины таблицы не покрывают: худший случай, не больше 1/4 лжесвидетелей на раунд
+    return std::max(1, static_cast<int>(ceil(log2(1.0 / (1.0 - min_probability)) / 2.0)));
+}
+
+bool MillerRabinTest::IsPrime(const big_int& n, double min_probability) const {
+    if (min_probability < 0.5 || min_probability >= 1.0) {
+        throw std::invalid_argument("Вероятность должна быть в диапазоне [0.5, 1)");
     }
-    big_int a = GenerateRandomBigInt(2, n - 2);
-    big_int x = CryptoService::ModPow(a, d, n);
-    if (x == 1 || x == n - 1) {
-        return true;
+    if (n < 2) {
+        return false;
     }
-    for (big_int r = 1; r < s; r++) {
-        x = CryptoService::ModPow(x, 2, n);
-        if (x == n - 1) {
+    for (unsigned p : MR_PRIME_BASES) {
+        if (n == p) {
+            return true;
+        }
+        if (mpz_divisible_ui_p(n.backend().data(), p)) {
+            return false;
+        }
+    }
+
+    big_int d;
+    const unsigned s = split_power_of_two(n - 1, d);
+    const ExponentChain d_chain(d);
+    const MontgomeryContext ctx(n);
+
+    static const std::vector<big_int> bounds = [] {
+        std::vector<big_int> result;
+        for (const DeterministicBases& entry : MR_DETERMINISTIC_BASES) {
+            result.emplace_back(entry.bound);
+        }
+        return result;
+    }();
+    for (size_t i = 0; i < bounds.size(); ++i) {
+        if (n < bounds[i]) {
+            for (size_t j = 0; j < MR_DETERMINISTIC_BASES[i].count; ++j) {
+                if (!ctx.StrongProbablePrime(MR_PRIME_BASES[j], d_chain, s)) {
+                    return false;
+                }
+            }
             return true;
         }
     }
-    return false;
-}
\ No newline at end of file
+
+    if (_bpsw_above_deterministic) {
+        return ctx.StrongProbablePrime(2, d_chain, s) && BailliePSWTest::StrongLucasProbablePrime(n);
+    }
+
+    const int rounds = RoundCount(static_cast<unsigned>(boost::multiprecision::msb(n)) + 1, min_probability);
+    for (int i = 0; i < rounds; ++i) {
+        if (!ctx.StrongProbablePrime(GenerateRandomBigInt(2, n - 2), d_chain, s)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MillerRabinTest::PerformSingleIteration(const big_int& n, const MontgomeryContext& ctx) const {
+    big_int d;
+    const unsigned s = split_power_of_two(n - 1, d);
+    return ctx.StrongProbablePrime(GenerateRandomBigInt(2, n - 2), ExponentChain(d), s);
+}
+
+bool BailliePSWTest::IsPrime(const big_int& n, double min_probability) const {
+    if (min_probability < 0.5 || min_probability >= 1.0) {
+        throw std::invalid_argument("Вероятность должна быть в диапазоне [0.5, 1)");
+    }
+    if (n < 2) {
+        return false;
+    }
+    for (unsigned p : MR_PRIME_BASES) {
+        if (n == p) {
+            return true;
+        }
+        if (mpz_divisible_ui_p(n.backend().data(), p)) {
+            return false;
+        }
+    }
+    const MontgomeryContext ctx(n);
+    return PerformSingleIteration(n, ctx);
+}
+
+bool BailliePSWTest::PerformSingleIteration(const big_int& n, const MontgomeryContext& ctx) const {
+    big_int d;
+    const unsigned s = split_power_of_two(n - 1, d);
+    return ctx.StrongProbablePrime(2, ExponentChain(d), s) && StrongLucasProbablePrime(n);
+}
+
+bool BailliePSWTest::StrongLucasProbablePrime(const big_int& n) {
+    if (mpz_perfect_square_p(n.backend().data())) {
+        return false;
+    }
+    long D = 5;
+    while (true) {
+        const int jacobi = CryptoService::JacobiSymbol(big_int(D), n);
+        if (jacobi == -1) {
+            break;
+        }
+        if (jacobi == 0 && boost::multiprecision::abs(big_int(D)) != n) {
+            return false;
+        }
+        D = D > 0 ? -(D + 2) : -D + 2;
+    }
+    const long Q = (1 - D) / 4;
+
+    big_int d;
+    const unsigned s = split_power_of_two(n + 1, d);
+
+    const mpz_srcptr mod = n.backend().data();
+    mpz_t U, V, Qk, t, big_D, big_Q;
+    mpz_inits(U, V, Qk, t, big_D, big_Q, nullptr);
+    mpz_set_si(big_D, D);
+    mpz_mod(big_D, big_D, mod);
+    mpz_set_si(big_Q, Q);
+    mpz_mod(big_Q, big_Q, mod);
+
+    // U_1 = 1, V_1 = P = 1, Q^1; дальше удвоение индекса и, для единичных бит, +1
+    mpz_set_ui(U, 1);
+    mpz_set_ui(V, 1);
+    mpz_set(Qk, big_Q);
+    const mpz_srcptr d_z = d.backend().data();
+    for (long i = static_cast<long>(mpz_sizeinbase(d_z, 2)) - 2; i >= 0; --i) {
+        // U_2k = U_k * V_k, V_2k = V_k^2 - 2 Q^k
+        mpz_mul(U, U, V);
+        mpz_mod(U, U, mod);
+        mpz_mul(V, V, V);
+        mpz_submul_ui(V, Qk, 2);
+        mpz_mod(V, V, mod);
+        mpz_mul(Qk, Qk, Qk);
+        mpz_mod(Qk, Qk, mod);
+        if (mpz_tstbit(d_z, i)) {
+            // U_k+1 = (P U_k + V_k) / 2, V_k+1 = (D U_k + P V_k) / 2
+            mpz_mul(t, big_D, U);
+            mpz_add(U, U, V);
+            mpz_mod(U, U, mod);
+            half_mod(U, mod);
+            mpz_add(V, V, t);
+            mpz_mod(V, V, mod);
+            half_mod(V, mod);
+            mpz_mul(Qk, Qk, big_Q);
+            mpz_mod(Qk, Qk, mod);
+        }
+    }
+
+    bool probable_prime = mpz_sgn(U) == 0 || mpz_sgn(V) == 0;
+    for (unsigned r = 1; r < s && !probable_prime; ++r) {
+        // V_2k = V_k^2 - 2 Q^k
+        mpz_mul(V, V, V);
+        mpz_submul_ui(V, Qk, 2);
+        mpz_mod(V, V, mod);
+        mpz_mul(Qk, Qk, Qk);
+        mpz_mod(Qk, Qk, mod);
+        probable_prime = mpz_sgn(V) == 0;
+    }
+    mpz_clears(U, V, Qk, t, big_D, big_Q, nullptr);
+    return probable_prime;
+}
@@ -8,6 +8,7 @@
 #ifndef PRIMALITY_TEST_H
 #define PRIMALITY_TEST_H
 #include "StatelessService.h"
+#include "MontgomeryContext.h"
 #include <boost/multiprecision/gmp.hpp>
 
 // Определяем big_int как тип из Boost
@@ -44,9 +45,10 @@ protected:
     /**
      * @brief Выполняет одну итерацию теста. Реализуется в дочерних классах.
      * @param n Тестируемое число.
+     * @param ctx Контекст Монтгомери по модулю n, общий для всех итераций.
      * @return true, если итерация пройдена, иначе false.
      */
-    virtual bool PerformSingleIteration(const big_int& n) const = 0;
+    virtual bool PerformSingleIteration(const big_int& n, const MontgomeryContext& ctx) const = 0;
 
     /**
      * @brief Вспомогательный метод для генерации случайного числа в диапазоне.
@@ -61,17 +63,58 @@ protected:
 
 class FermatTest : public PrimalityTest {
 protected:
-    bool PerformSingleIteration(const big_int& n) const override;
+    bool PerformSingleIteration(const big_int& n, const MontgomeryContext& ctx) const override;
 };
 
 class SolovayStrassenTest : public PrimalityTest {
 protected:
-    bool PerformSingleIteration(const big_int& n) const override;
+    bool PerformSingleIteration(const big_int& n, const MontgomeryContext& ctx) const override;
 };
 
+/**
+ * @class MillerRabinTest
+ * @brief Тест Миллера-Рабина. n - 1 = d * 2^s раскладывается один раз на число, все основания
+ *        используют один контекст Монтгомери.
+ *        n < 3.3 * 10^24 проверяется детерминированно по простым основаниям 2..41.
+ *        Для больших n число раундов со случайными основаниями берется из таблиц FIPS 186-5
+ *        по длине n (для n короче 512 бит - из min_probability с оценкой 1/4 на раунд),
+ *        либо, если включен режим bpsw_above_deterministic, выполняется тест Бэйли-PSW.
+ */
 class MillerRabinTest : public PrimalityTest {
+public:
+    explicit MillerRabinTest(bool bpsw_above_deterministic = false)
+            : _bpsw_above_deterministic(bpsw_above_deterministic) {}
+
+    bool IsPrime(const big_int& n, double min_probability) const override;
+
+    /** @brief Число раундов со случайными основаниями для n длиной bits бит. */
+    static int RoundCount(unsigned bits, double min_probability);
+
+protected:
+    bool PerformSingleIteration(const big_int& n, const MontgomeryContext& ctx) const override;
+
+private:
+    bool _bpsw_above_deterministic;
+};
+
+/**
+ * @class BailliePSWTest
+ * @brief Тест Бэйли-PSW: сильный тест по основанию 2 и сильный тест Люка с параметрами Селфриджа.
+ *        Контрпримеры неизвестны, поэтому min_probability на число проверок не влияет:
+ *        выполняется ровно одна итерация стоимостью около трех возведений в степень.
+ */
+class BailliePSWTest : public PrimalityTest {
+public:
+    bool IsPrime(const big_int& n, double min_probability) const override;
+
+    /**
+     * @brief Сильный тест Люка: первое D из 5, -7, 9, -11, ... с (D/n) = -1, P = 1, Q = (1 - D) / 4.
+     * @param n Нечетное число, больше 2.
+     */
+    static bool StrongLucasProbablePrime(const big_int& n);
+
 protected:
-    bool PerformSingleIteration(const big_int& n) const override;
+    bool PerformSingleIteration(const big_int& n, const MontgomeryContext& ctx) const override;
 };
 
 #endif //PRIMALITY_TEST_H
@@ -0,0 +1,166 @@
+#include "RsaKeyPool.h"
+#include <stdexcept>
+#include <utility>
+
+RsaKeyPool::RsaKeyPool() : RsaKeyPool(Config()) {}
+
+RsaKeyPool::RsaKeyPool(const Config& config) : _config(config) {
+    if (_config.high_watermark == 0 || _config.low_watermark > _config.high_watermark) {
+        throw std::invalid_argument("Нужно 0 <= low_watermark <= high_watermark, high_watermark > 0");
+    }
+    if (_config.refill_threads == 0) {
+        throw std::invalid_argument("Пулу нужен хотя бы один фоновый поток");
+    }
+    for (unsigned i = 0; i < _config.refill_threads; ++i) {
+        _workers.emplace_back(&RsaKeyPool::_refill_worker, this);
+    }
+}
+
+RsaKeyPool::~RsaKeyPool() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _work_available.notify_all();
+    _key_available.notify_all();
+    for (auto& worker : _workers) {
+        worker.join();
+    }
+}
+
+RsaKeyPool::Bucket& RsaKeyPool::_bucket(int bit_length, RsaService::PrimalityTestType type) {
+    auto it = _buckets.find({bit_length, type});
+    if (it == _buckets.end()) {
+        it = _buckets.emplace(BucketKey{bit_length, type}, Bucket()).first;
+        it->second.generator = std::make_unique<RsaService::KeyGenerator>(type, _config.probability, bit_length);
+        it->second.generator->SetThreadCount(_config.search_threads);
+        it->second.generator->SetVerbose(false);
+    }
+    return it->second;
+}
+
+void RsaKeyPool::_update_refill(Bucket& bucket) {
+    // гистерезис: наполнение начинается ниже low_watermark и идет до high_watermark
+    if (bucket.ready.size() < _config.low_watermark || (bucket.ready.empty() && !bucket.generating)) {
+        if (!bucket.refilling) {
+            bucket.refilling = true;
+            _work_available.notify_one();
+        }
+    }
+    if (bucket.ready.size() >= _config.high_watermark) {
+        bucket.refilling = false;
+    }
+}
+
+std::optional<RsaKeyPool::KeyPair> RsaKeyPool::_pop(Bucket& bucket) {
+    if (bucket.ready.empty()) {
+        return std::nullopt;
+    }
+    KeyPair key_pair = std::move(bucket.ready.front());
+    bucket.ready.pop_front();
+    ++bucket.stats.served;
+    _update_refill(bucket);
+    return key_pair;
+}
+
+void RsaKeyPool::_rethrow_error(Bucket& bucket) {
+    if (bucket.error) {
+        std::exception_ptr error = std::exchange(bucket.error, nullptr);
+        std::rethrow_exception(error);
+    }
+}
+
+void RsaKeyPool::Reserve(int bit_length, RsaService::PrimalityTestType type) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _update_refill(_bucket(bit_length, type));
+}
+
+RsaKeyPool::KeyPair RsaKeyPool::Acquire(int bit_length, RsaService::PrimalityTestType type) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    Bucket& bucket = _bucket(bit_length, type);
+    if (auto key_pair = _pop(bucket)) {
+        return std::move(*key_pair);
+    }
+    _rethrow_error(bucket);
+    _update_refill(bucket);
+    _key_available.wait(lock, [this, &bucket] { return _stopping || !bucket.ready.empty() || bucket.error; });
+    if (bucket.ready.empty()) {
+        _rethrow_error(bucket);
+        throw std::runtime_error("Пул ключей остановлен");
+    }
+    ++bucket.stats.served_waiting;
+    return std::move(*_pop(bucket));
+}
+
+std::optional<RsaKeyPool::KeyPair> RsaKeyPool::TryAcquire(int bit_length, RsaService::PrimalityTestType type) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    Bucket& bucket = _bucket(bit_length, type);
+    auto key_pair = _pop(bucket);
+    if (!key_pair) {
+        ++bucket.stats.missed;
+        _rethrow_error(bucket);
+        _update_refill(bucket);
+    }
+    return key_pair;
+}
+
+RsaKeyPool::Stats RsaKeyPool::GetStats(int bit_length, RsaService::PrimalityTestType type) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _buckets.find({bit_length, type});
+    if (it == _buckets.end()) {
+        return Stats();
+    }
+    Stats stats = it->second.stats;
+    stats.ready = it->second.ready.size();
+    return stats;
+}
+
+void RsaKeyPool::_refill_worker() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true) {
+        Bucket* target = nullptr;
+        _work_available.wait(lock, [this, &target] {
+            if (_stopping) {
+                return true;
+            }
+            for (auto& entry : _buckets) {
+                Bucket& bucket = entry.second;
+                if (bucket.refilling && !bucket.generating) {
+                    target = &bucket;
+                    return true;
+                }
+            }
+            return false;
+        });
+        if (_stopping) {
+            return;
+        }
+
+        target->generating = true;
+        lock.unlock();
+        std::optional<KeyPair> key_pair;
+        std::exception_ptr error;
+        try {
+            key_pair = target->generator->Generate();
+        } catch (...) {
+            error = std::current_exception();
+        }
+        lock.lock();
+        target->generating = false;
+
+        if (error) {
+            // очередь не наполняется повторно, пока ошибку не заберет Acquire/TryAcquire
+            target->error = error;
+            target->refilling = false;
+            _key_available.notify_all();
+            _work_available.notify_one();
+            continue;
+        }
+        target->ready.push_back(std::move(*key_pair));
+        ++target->stats.generated;
+        _update_refill(*target);
+        _key_available.notify_all();
+        // другие очереди могли ждать, пока этот поток был занят
+        _work_available.notify_one();
+    }
+}
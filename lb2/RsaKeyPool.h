@@ -0,0 +1,99 @@
+#ifndef CRYPTOGRAPHY_RSAKEYPOOL_H
+#define CRYPTOGRAPHY_RSAKEYPOOL_H
+
+#include "RsaService.h"
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * @class RsaKeyPool
+ * @brief Пул заранее сгенерированных ключевых пар RSA.
+ *        Для каждой пары (длина ключа, тест простоты) фоновые потоки держат ограниченную очередь
+ *        готовых ключей: когда в очереди остается меньше low_watermark ключей, она дополняется
+ *        до high_watermark. Acquire забирает готовый ключ без поиска простых; если очередь пуста,
+ *        ждет ближайший ключ от фоновой генерации.
+ */
+class RsaKeyPool {
+public:
+    using KeyPair = std::pair<RsaPublicKey, RsaPrivateKey>;
+
+    struct Config {
+        size_t low_watermark = 2;
+        size_t high_watermark = 8;
+        unsigned refill_threads = 1;
+        // потоки поиска простых внутри одной генерации (0 - по числу ядер)
+        unsigned search_threads = 1;
+        double probability = 0.999;
+    };
+
+    struct Stats {
+        size_t ready = 0;              // ключей в очереди сейчас
+        uint64_t generated = 0;        // сгенерировано фоновыми потоками
+        uint64_t served = 0;           // выдано через Acquire/TryAcquire
+        uint64_t served_waiting = 0;   // из них - после ожидания на пустой очереди
+        uint64_t missed = 0;           // TryAcquire на пустой очереди
+    };
+
+    RsaKeyPool();
+    explicit RsaKeyPool(const Config& config);
+    // Дожидается окончания начатых генераций и останавливает фоновые потоки
+    ~RsaKeyPool();
+
+    RsaKeyPool(const RsaKeyPool&) = delete;
+    RsaKeyPool& operator=(const RsaKeyPool&) = delete;
+
+    /** @brief Начать наполнение очереди для (bit_length, type) заранее, не дожидаясь первого запроса. */
+    void Reserve(int bit_length, RsaService::PrimalityTestType type);
+    /**
+     * @brief Готовый ключ; при пустой очереди блокируется до появления ключа.
+     * @throws Исключение фоновой генерации для этой очереди (один раз; следующий вызов запускает ее снова).
+     */
+    KeyPair Acquire(int bit_length, RsaService::PrimalityTestType type);
+    /**
+     * @brief Готовый ключ или std::nullopt, если очередь пуста (фоновое наполнение при этом запускается).
+     * @throws Как Acquire, если очередь пуста из-за ошибки фоновой генерации.
+     */
+    std::optional<KeyPair> TryAcquire(int bit_length, RsaService::PrimalityTestType type);
+
+    Stats GetStats(int bit_length, RsaService::PrimalityTestType type) const;
+    const Config& GetConfig() const { return _config; }
+
+private:
+    using BucketKey = std::pair<int, RsaService::PrimalityTestType>;
+
+    struct Bucket {
+        std::deque<KeyPair> ready;
+        // генератор хранит позицию поиска и не рассчитан на параллельные вызовы: им пользуется один поток
+        std::unique_ptr<RsaService::KeyGenerator> generator;
+        bool refilling = false;
+        bool generating = false;
+        // исключение фоновой генерации; передается следующему Acquire/TryAcquire на пустой очереди
+        std::exception_ptr error;
+        Stats stats;
+    };
+
+    // вызывается под _mutex
+    Bucket& _bucket(int bit_length, RsaService::PrimalityTestType type);
+    void _update_refill(Bucket& bucket);
+    std::optional<KeyPair> _pop(Bucket& bucket);
+    void _rethrow_error(Bucket& bucket);
+    void _refill_worker();
+
+    Config _config;
+    mutable std::mutex _mutex;
+    std::condition_variable _work_available;
+    std::condition_variable _key_available;
+    std::map<BucketKey, Bucket> _buckets;
+    bool _stopping = false;
+    std::vector<std::thread> _workers;
+};
+
+#endif //CRYPTOGRAPHY_RSAKEYPOOL_H
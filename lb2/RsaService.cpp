@@ -1,12 +1,18 @@
 #include "RsaService.h"
 #include "StatelessService.h"
+#include "ChaCha20Random.h"
+#include "RsaKeyPool.h"
+#include "ParallelFor.h"
 #include <iostream>
+#include <sstream>
+#include <string>
 #include <stdexcept>
 #include <tuple>
 #include <vector>
+#include <algorithm>
+#include <limits>
 
 namespace {
-    std::mutex g_cout_mutex;
     std::vector<int> generate_small_primes(int limit) {
         std::vector<bool> is_prime(limit + 1, true);
         is_prime[0] = is_prime[1] = false;
@@ -26,52 +32,152 @@ namespace {
     }
 }
 
-RsaService::RsaService(PrimalityTestType type, double probability, int bit_length)
-        : _keyGenerator(type, probability, bit_length) {
+RsaService::RsaService(PrimalityTestType type, double probability, int bit_length,
+                       std::optional<uint64_t> seed)
+        : _keyGenerator(type, probability, bit_length, seed) {
     GenerateKeys();
 }
 
+RsaService::RsaService(RsaKeyPool& pool, PrimalityTestType type, int bit_length)
+        : _keyGenerator(type, pool.GetConfig().probability, bit_length) {
+    _install_key_pair(pool.Acquire(bit_length, type));
+}
+
 void RsaService::GenerateKeys() {
-    auto key_pair = _keyGenerator.Generate();
+    _install_key_pair(_keyGenerator.Generate());
+}
+
+big_int RsaService::GeneratePrime() {
+    return _keyGenerator.GeneratePrime();
+}
+
+void RsaService::_install_key_pair(const std::pair<RsaPublicKey, RsaPrivateKey>& key_pair) {
     _publicKey = key_pair.first;
     _privateKey = key_pair.second;
+    _update_key_precomputation();
+}
+
+void RsaService::_update_key_precomputation() {
+    _montgomery = std::make_shared<const MontgomeryContext>(_publicKey.n);
+    _public_exponent_chain = std::make_shared<const ExponentChain>(_publicKey.e);
+    if (_privateKey.p.is_zero()) {
+        _montgomery_p.reset();
+        _montgomery_q.reset();
+        return;
+    }
+    _montgomery_p = std::make_shared<const MontgomeryContext>(_privateKey.p);
+    _montgomery_q = std::make_shared<const MontgomeryContext>(_privateKey.q);
+}
+
+big_int RsaService::_private_operation(const big_int& x, bool allow_parallel) const {
+    if (!_montgomery_p) {
+        return _montgomery->Pow(x, _privateKey.d);
+    }
+    const RsaPrivateKey& key = _privateKey;
+    big_int m1;
+    big_int m2;
+    if (_parallel_crt && allow_parallel) {
+        auto future_m1 = std::async(std::launch::async, [this, &x, &key]() {
+            return _montgomery_p->Pow(x, key.dp);
+        });
+        m2 = _montgomery_q->Pow(x, key.dq);
+        m1 = future_m1.get();
+    } else {
+        m1 = _montgomery_p->Pow(x, key.dp);
+        m2 = _montgomery_q->Pow(x, key.dq);
+    }
+    // Гарнер: m = m2 + q * (qInv * (m1 - m2) mod p)
+    big_int h = (m1 - m2) * key.qInv % key.p;
+    if (h < 0) {
+        h += key.p;
+    }
+    return m2 + h * key.q;
 }
 
 big_int RsaService::Encrypt(const big_int& message) const {
     if (_publicKey.n.is_zero()) {
         throw std::runtime_error("Ключи не сгенерированы");
     }
-    return CryptoService::ModPow(message, _publicKey.e, _publicKey.n);
+    return _montgomery->Pow(message, *_public_exponent_chain);
 }
 
 big_int RsaService::Decrypt(const big_int& ciphertext) const {
     if (_privateKey.n.is_zero()) {
         throw std::runtime_error("Ключи не сгенерированы");
     }
-    return CryptoService::ModPow(ciphertext, _privateKey.d, _privateKey.n);
+    return _private_operation(ciphertext);
+}
+
+template <typename Operation>
+std::vector<big_int> RsaService::_run_batch(const std::vector<big_int>& input, Operation operation) {
+    std::vector<big_int> output(input.size());
+    parallel_for(0, input.size(), std::max(1u, std::thread::hardware_concurrency()), 1, [&](size_t i) {
+        output[i] = operation(input[i]);
+    });
+    return output;
 }
 
+std::vector<big_int> RsaService::EncryptBatch(const std::vector<big_int>& messages) const {
+    if (_publicKey.n.is_zero()) {
+        throw std::runtime_error("Ключи не сгенерированы");
+    }
+    return _run_batch(messages, [this](const big_int& m) {
+        return _montgomery->Pow(m, *_public_exponent_chain);
+    });
+}
 
-RsaService::KeyGenerator::KeyGenerator(PrimalityTestType type, double probability, int bit_length)
-        : _probability(probability), _bit_length(bit_length), _key_found_flag(false) {
+std::vector<big_int> RsaService::DecryptBatch(const std::vector<big_int>& ciphertexts) const {
+    if (_privateKey.n.is_zero()) {
+        throw std::runtime_error("Ключи не сгенерированы");
+    }
+    // внутри пакета параллельность уже по элементам, поэтому КТО считается в одном потоке
+    return _run_batch(ciphertexts, [this](const big_int& c) {
+        return _private_operation(c, false);
+    });
+}
+
+big_int RsaService::Sign(const big_int& message) const {
+    if (_privateKey.n.is_zero()) {
+        throw std::runtime_error("Ключи не сгенерированы");
+    }
+    return _private_operation(message);
+}
+
+bool RsaService::Verify(const big_int& message, const big_int& signature) const {
+    return Encrypt(signature) == message % _publicKey.n;
+}
+
+
+RsaService::KeyGenerator::KeyGenerator(PrimalityTestType type, double probability, int bit_length,
+                                       std::optional<uint64_t> seed)
+        : _probability(probability), _bit_length(bit_length) {
     switch (type) {
         case FERMAT: _primality_test = std::make_unique<FermatTest>(); break;
         case SOLOVAY_STRASSEN: _primality_test = std::make_unique<SolovayStrassenTest>(); break;
         case MILLER_RABIN: _primality_test = std::make_unique<MillerRabinTest>(); break;
+        case BAILLIE_PSW: _primality_test = std::make_unique<BailliePSWTest>(); break;
     }
     _prime_min_val = big_int(1) << (_bit_length - 1);
     _prime_max_val = (big_int(1) << _bit_length) - big_int(1);
+    // Без seed ключ потоков - полные 256 бит из getrandom: 64-битный seed перебирается, и ключи RSA
+    // по умолчанию были бы не стойче него. seed - только для явно воспроизводимых запусков
+    _key = seed ? ChaCha20Random::SeedKey(*seed) : ChaCha20Random::SystemKey();
+}
+
+big_int RsaService::KeyGenerator::_stream_random(const big_int& min, const big_int& max, uint64_t stream) const {
+    ChaCha20Random generator(_key, stream);
+    return generator.Uniform(min, max);
 }
 
 
 std::pair<RsaPublicKey, RsaPrivateKey> RsaService::KeyGenerator::Generate() {
     while (true) {
-        auto future_p = std::async(std::launch::async, &RsaService::KeyGenerator::GeneratePrime, this);
+        // p и q - два следующих простых последовательности; параллельность внутри GeneratePrime
+        const big_int p = GeneratePrime();
         big_int q = GeneratePrime();
-        big_int p = future_p.get();
         while (p == q) q = GeneratePrime();
 
-        std::cout << "p и q найдены. Проверяем безопасность" << std::endl;
+        if (_verbose) std::cout << "p и q найдены. Проверяем безопасность" << std::endl;
 
         const big_int n = p * q;
         const big_int phi = (p - 1) * (q - 1);
@@ -83,7 +189,7 @@ std::pair<RsaPublicKey, RsaPrivateKey> RsaService::KeyGenerator::Generate() {
             if (CryptoService::Gcd(cand, phi) == 1) { e = cand; e_found = true; break; }
         }
         if (!e_found) {
-            do { e = PrimalityTest::GenerateRandomBigInt(3, phi - 1); }
+            do { e = _stream_random(3, phi - 1, _next_aux_stream--); }
             while (e % 2 == 0 || CryptoService::Gcd(e, phi) != 1);
         }
 
@@ -91,101 +197,140 @@ std::pair<RsaPublicKey, RsaPrivateKey> RsaService::KeyGenerator::Generate() {
         CryptoService::ExtendedGcd(e, phi, x, y);
         const big_int d = (x % phi + phi) % phi;
 
-        if (boost::multiprecision::abs(p - q) < Sqrt(Sqrt(n))) {
-            std::cout << "Ключ отвергнут: p и q слишком близки (уязвимость Ферма). Повторная попытка" << std::endl;
+        const big_int quarter_root = FourthRoot(n);
+        if (boost::multiprecision::abs(p - q) < quarter_root) {
+            if (_verbose) std::cout << "Ключ отвергнут: p и q слишком близки (уязвимость Ферма). Повторная попытка" << std::endl;
             continue;
         }
 
-        if (d < (Sqrt(Sqrt(n)) / 3)) {
-            std::cout << "Ключ отвергнут: d слишком мало (уязвимость Винера). Повторная попытка" << std::endl;
+        if (d < quarter_root / 3) {
+            if (_verbose) std::cout << "Ключ отвергнут: d слишком мало (уязвимость Винера). Повторная попытка" << std::endl;
             continue;
         }
 
-        std::cout << "Ключ прошел проверки безопасности." << std::endl;
-        return {{n, e}, {n, d}};
+        if (_verbose) std::cout << "Ключ прошел проверки безопасности." << std::endl;
+        return {{n, e}, _make_private_key(p, q, d)};
     }
 }
 
-std::tuple<big_int, big_int, big_int> RsaService::KeyGenerator::_create_key_candidate() const {
-    const big_int p = GeneratePrime();
-    big_int q;
-    do { q = GeneratePrime(); } while (p == q);
-    const big_int n = p * q;
-    const big_int phi = (p - big_int(1)) * (q - big_int(1));
 
-    static const std::vector<big_int> exponents = {big_int(65537), big_int(257), big_int(17)};
-    big_int e;
-    bool e_found = false;
-
-    for (const auto& exp_candidate : exponents) {
-        if (CryptoService::Gcd(exp_candidate, phi) == big_int(1)) {
-            e = exp_candidate;
-            e_found = true;
-            break;
+void RsaService::KeyGenerator::_search_worker(SearchRound& round) const {
+    const std::vector<size_t>& survivors = *round.survivors;
+    while (true) {
+        // индексы раздаются по возрастанию, поэтому после найденного простого все следующие уже не нужны
+        const size_t index = round.next_index.fetch_add(1);
+        if (index >= survivors.size() || index > round.found_index.load()) {
+            return;
         }
-    }
-
-    if (!e_found) {
-        while (true) {
-            e = PrimalityTest::GenerateRandomBigInt(big_int(3), phi - big_int(1));
-            if (e % big_int(2) != big_int(0) && CryptoService::Gcd(e, phi) == big_int(1)) {
-                break;
+        const big_int candidate = *round.base + 2 * survivors[index];
+        if (_primality_test->IsPrime(candidate, _probability)) {
+            size_t current = round.found_index.load();
+            while (index < current && !round.found_index.compare_exchange_weak(current, index)) {
             }
+            return;
         }
     }
-    big_int x, y;
-    CryptoService::ExtendedGcd(e, phi, x, y);
-    const big_int d = (x % phi + phi) % phi;
-    return {e, d, n};
 }
 
+big_int RsaService::KeyGenerator::GeneratePrime() {
+    // ~4200 простых до 40000; в решете участвуют только те, что меньше кандидатов
+    static const std::vector<int> small_primes = generate_small_primes(SIEVE_PRIME_LIMIT);
 
-big_int RsaService::KeyGenerator::GeneratePrime() const {
-    static std::vector<int> small_primes = generate_small_primes(1000);
+    const big_int& min_val = _prime_min_val;
+    const big_int& max_val = _prime_max_val;
 
-    big_int min_val = big_int(1) << (_bit_length - 1);
-    big_int max_val = (big_int(1) << _bit_length) - 1;
+    std::vector<unsigned long> sieve_primes;
+    for (int p : small_primes) {
+        if (p > 2 && big_int(p) < min_val) {
+            sieve_primes.push_back(static_cast<unsigned long>(p));
+        }
+    }
+    std::vector<unsigned long> residues(sieve_primes.size());
+    std::vector<bool> composite(SIEVE_WINDOW);
+    std::vector<size_t> survivors;
+    const size_t num_threads = _num_threads ? _num_threads : std::max(1u, std::thread::hardware_concurrency());
 
     while (true) {
-        big_int candidate = PrimalityTest::GenerateRandomBigInt(min_val, max_val);
-        candidate |= (big_int(1) << (_bit_length - 1));
-        candidate |= 1;
-
-        bool composite_by_small = false;
-        for (int p : small_primes) {
-            big_int bp(p);
-            if (candidate == bp) {
-                composite_by_small = false;
-                break;
+        // стартовая точка определяется только seed и номером потока,
+        // свежая точка для каждого простого не дает p и q оказаться соседними простыми
+        big_int base = _stream_random(min_val, max_val, _next_prime_stream++) | 1;
+
+        // остатки по малым простым считаются один раз для стартовой точки, дальше - только машинные слова
+        for (size_t i = 0; i < sieve_primes.size(); ++i) {
+            residues[i] = mpz_fdiv_ui(base.backend().data(), sieve_primes[i]);
+        }
+
+        for (size_t window = 0; window < SIEVE_WINDOWS_PER_START && base <= max_val; ++window) {
+            // composite[k] - кандидат base + 2k делится на одно из малых простых
+            std::fill(composite.begin(), composite.end(), false);
+            for (size_t i = 0; i < sieve_primes.size(); ++i) {
+                const unsigned long p = sieve_primes[i];
+                // base + 2k = 0 (mod p)  =>  k = -r * 2^-1 (mod p)
+                unsigned long k = ((p - residues[i]) % p) * ((p + 1) / 2) % p;
+                for (; k < SIEVE_WINDOW; k += p) {
+                    composite[k] = true;
+                }
             }
-            if (candidate % bp == 0) {
-                composite_by_small = true;
-                break;
+
+            survivors.clear();
+            for (size_t k = 0; k < SIEVE_WINDOW; ++k) {
+                if (composite[k]) {
+                    continue;
+                }
+                if (base + 2 * k > max_val) {
+                    break;
+                }
+                survivors.push_back(k);
+            }
+
+            // Кандидаты окна проверяются параллельно, но ответом всегда будет первый простой по порядку
+            SearchRound round;
+            round.base = &base;
+            round.survivors = &survivors;
+            round.found_index = std::numeric_limits<size_t>::max();
+            const size_t workers = std::min(num_threads, survivors.size());
+            std::vector<std::future<void>> futures;
+            for (size_t t = 1; t < workers; ++t) {
+                futures.push_back(std::async(std::launch::async, &KeyGenerator::_search_worker, this, std::ref(round)));
+            }
+            _search_worker(round);
+            for (auto& fut : futures) {
+                fut.get();
+            }
+
+            if (round.found_index != std::numeric_limits<size_t>::max()) {
+                return base + 2 * survivors[round.found_index];
+            }
+
+            base += 2 * SIEVE_WINDOW;
+            for (size_t i = 0; i < sieve_primes.size(); ++i) {
+                residues[i] = (residues[i] + (2 * SIEVE_WINDOW) % sieve_primes[i]) % sieve_primes[i];
             }
-        }
-        if (composite_by_small) {
-            continue;
-        }
-        if (_primality_test->IsPrime(candidate, _probability)) {
-            return candidate;
         }
     }
 }
 
-big_int RsaService::KeyGenerator::Sqrt(const big_int& n) {
+RsaPrivateKey RsaService::KeyGenerator::_make_private_key(const big_int& p, const big_int& q, const big_int& d) {
+    RsaPrivateKey key;
+    key.n = p * q;
+    key.d = d;
+    key.p = p;
+    key.q = q;
+    key.dp = d % (p - 1);
+    key.dq = d % (q - 1);
+    big_int x, y;
+    CryptoService::ExtendedGcd(q, p, x, y);
+    key.qInv = (x % p + p) % p;
+    return key;
+}
+
+big_int RsaService::KeyGenerator::FourthRoot(const big_int& n) {
     if (n < big_int(0)) {
-        throw std::invalid_argument("sqrt для отрицательного числа");
+        throw std::invalid_argument("корень четвертой степени из отрицательного числа");
     }
-    if (n.is_zero()) {
-        return big_int(0);
-    }
-    big_int x = n;
-    big_int y = (x + big_int(1)) / big_int(2);
-    while (y < x) {
-        x = y;
-        y = (x + n / x) / big_int(2);
-    }
-    return x;
+    big_int root;
+    mpz_root(root.backend().data(), n.backend().data(), 4);
+    return root;
 }
 
 std::pair<RsaPublicKey, RsaPrivateKey> RsaService::KeyGenerator::GenerateWeak() {
@@ -196,25 +341,80 @@ std::pair<RsaPublicKey, RsaPrivateKey> RsaService::KeyGenerator::GenerateWeak()
         const big_int n = p * q;
         const big_int phi = (p - big_int(1)) * (q - big_int(1));
 
-        big_int d_max = Sqrt(Sqrt(n)) / big_int(3);
+        big_int d_max = FourthRoot(n) / big_int(3);
         if (d_max < big_int(3)) {
             continue;
         }
 
-        big_int d = PrimalityTest::GenerateRandomBigInt(big_int(3), d_max);
+        big_int d = _stream_random(big_int(3), d_max, _next_aux_stream--);
         if (d % big_int(2) == big_int(0)) d++;
 
         if (CryptoService::Gcd(d, phi) == big_int(1)) {
             big_int x, y;
             CryptoService::ExtendedGcd(d, phi, x, y);
             big_int e = (x % phi + phi) % phi;
-            return {{n, e}, {n, d}};
+            return {{n, e}, _make_private_key(p, q, d)};
+        }
+    }
+}
+
+std::pair<RsaPublicKey, RsaPrivateKey> RsaService::KeyGenerator::GenerateWeak(double d_exponent) {
+    if (!(d_exponent > 0 && d_exponent < 1)) {
+        throw std::invalid_argument("d_exponent должен быть в интервале (0, 1)");
+    }
+    while (true) {
+        const big_int p = GeneratePrime();
+        big_int q;
+        do { q = GeneratePrime(); } while (p == q);
+        const big_int n = p * q;
+        const big_int phi = (p - big_int(1)) * (q - big_int(1));
+
+        // d - нечетное число ровно из d_bits бит
+        const size_t d_bits = static_cast<size_t>(d_exponent * static_cast<double>(mpz_sizeinbase(n.backend().data(), 2) - 1));
+        if (d_bits < 2) {
+            throw std::invalid_argument("d_exponent слишком мал для этой длины ключа");
+        }
+        const big_int d_min = big_int(1) << (d_bits - 1);
+        big_int d = _stream_random(d_min, 2 * d_min - 1, _next_aux_stream--) | 1;
+
+        if (CryptoService::Gcd(d, phi) == big_int(1)) {
+            big_int x, y;
+            CryptoService::ExtendedGcd(d, phi, x, y);
+            big_int e = (x % phi + phi) % phi;
+            return {{n, e}, _make_private_key(p, q, d)};
         }
     }
 }
 
 void RsaService::GenerateWeakKeys() {
-    auto key_pair = _keyGenerator.GenerateWeak();
-    _publicKey = key_pair.first;
-    _privateKey = key_pair.second;
-}
\ No newline at end of file
+    _install_key_pair(_keyGenerator.GenerateWeak());
+}
+
+void RsaService::GenerateWeakKeys(double d_exponent) {
+    _install_key_pair(_keyGenerator.GenerateWeak(d_exponent));
+}
+
+bool ReadPublicKeys(std::istream& input, std::vector<RsaPublicKey>& keys, size_t max_count, size_t& line_number) {
+    keys.clear();
+    std::string line;
+    while (keys.size() < max_count && std::getline(input, line)) {
+        ++line_number;
+        const size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') {
+            continue;
+        }
+        std::istringstream fields(line);
+        std::string n_text;
+        std::string e_text;
+        std::string extra;
+        if (!(fields >> n_text >> e_text) || (fields >> extra)) {
+            throw std::invalid_argument("Строка " + std::to_string(line_number) + ": ожидается \"n e\"");
+        }
+        try {
+            keys.push_back({big_int(n_text), big_int(e_text)});
+        } catch (const std::exception&) {
+            throw std::invalid_argument("Строка " + std::to_string(line_number) + ": некорректное число");
+        }
+    }
+    return !keys.empty();
+}
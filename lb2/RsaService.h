@@ -11,6 +11,9 @@
 #include <optional>
 #include <tuple>
 #include <future>
+#include <cstdint>
+#include <array>
+#include <istream>
 #include <boost/multiprecision/gmp.hpp>// <-- Добавляем для std::async и std::future
 using big_int = boost::multiprecision::mpz_int;
 
@@ -23,54 +26,137 @@ struct RsaPublicKey {
 struct RsaPrivateKey {
     big_int n;
     big_int d;
+    // Параметры для КТО; p == 0, если ключ задан только парой {n, d}
+    big_int p;
+    big_int q;
+    big_int dp;   // d mod (p-1)
+    big_int dq;   // d mod (q-1)
+    big_int qInv; // q^-1 mod p
 };
 
+/**
+ * @brief Читает до max_count открытых ключей из потока (keys перезаписывается): по строке "n e" на ключ
+ *        (десятичные числа или шестнадцатеричные с префиксом 0x); пустые строки и строки с '#' пропускаются.
+ * @param line_number Номер последней прочитанной строки, продолжается между вызовами.
+ * @return false - поток исчерпан и keys пуст.
+ * @throws std::invalid_argument при некорректной строке (с ее номером).
+ */
+bool ReadPublicKeys(std::istream& input, std::vector<RsaPublicKey>& keys, size_t max_count, size_t& line_number);
+
+class RsaKeyPool;
+
 class RsaService {
 public:
     void GenerateKeys(); // Генерирует сильный ключ
     void GenerateWeakKeys(); // Генерирует слабый ключ
-    enum PrimalityTestType { FERMAT, SOLOVAY_STRASSEN, MILLER_RABIN };
+    // Ключ с d из floor(d_exponent * log2(n)) бит, т.е. d ~ n^d_exponent (0 < d_exponent < 1)
+    void GenerateWeakKeys(double d_exponent);
+    // Следующее простое из bit_length бит той же последовательности, что и при генерации ключей
+    // (при seed - воспроизводимое); текущий ключ не меняется
+    big_int GeneratePrime();
+    enum PrimalityTestType { FERMAT, SOLOVAY_STRASSEN, MILLER_RABIN, BAILLIE_PSW };
 
 private:
     class KeyGenerator {
     public:
-        KeyGenerator(PrimalityTestType type, double probability, int bit_length);
+        // seed задает последовательность кандидатов; без него берется из getrandom
+        KeyGenerator(PrimalityTestType type, double probability, int bit_length,
+                     std::optional<uint64_t> seed = std::nullopt);
         std::pair<RsaPublicKey, RsaPrivateKey> Generate();
         std::pair<RsaPublicKey, RsaPrivateKey> GenerateWeak(); // Новый метод
+        std::pair<RsaPublicKey, RsaPrivateKey> GenerateWeak(double d_exponent);
+        // 0 - по числу ядер
+        void SetThreadCount(unsigned threads) { _num_threads = threads; }
+        // Печатать ли ход генерации в std::cout
+        void SetVerbose(bool verbose) { _verbose = verbose; }
 
 
     private:
+        // Решето для поиска простых: окно из SIEVE_WINDOW нечетных кандидатов подряд
+        static constexpr int SIEVE_PRIME_LIMIT = 40000;
+        static constexpr size_t SIEVE_WINDOW = 4096;
+        static constexpr size_t SIEVE_WINDOWS_PER_START = 16;
+
+        // Общее состояние потоков, проверяющих выжившие после решета кандидаты одного окна
+        struct SearchRound {
+            const big_int* base;
+            const std::vector<size_t>* survivors;
+            std::atomic<size_t> next_index{0};
+            std::atomic<size_t> found_index; // наименьший индекс найденного простого
+        };
+
         big_int _prime_min_val;
         big_int _prime_max_val;
-        // Методы, не меняющие состояние объекта, помечаем const
-        std::tuple<big_int, big_int, big_int> _create_key_candidate() const;
-        big_int GeneratePrime() const;
+        // Следующее простое последовательности; результат не зависит от числа потоков.
+        // Снаружи генератора доступно только через RsaService::GeneratePrime
+        big_int GeneratePrime();
+        friend class RsaService;
+        static RsaPrivateKey _make_private_key(const big_int& p, const big_int& q, const big_int& d);
 
-        void _search_worker();
-        static big_int Sqrt(const big_int& n);
+        void _search_worker(SearchRound& round) const;
+        // Случайное число из [min, max], однозначно определяемое seed и номером потока stream
+        big_int _stream_random(const big_int& min, const big_int& max, uint64_t stream) const;
+        // floor(n^(1/4)): порог близости p и q (Ферма) и малости d (Винер)
+        static big_int FourthRoot(const big_int& n);
 
         // Члены класса
         std::unique_ptr<IPrimalityTest> _primality_test;
         double _probability;
         int _bit_length;
 
-        mutable std::atomic<bool> _key_found_flag;
-        std::mutex _result_mutex;
-        std::optional<std::pair<RsaPublicKey, RsaPrivateKey>> _found_key_pair;
-        mutable std::mutex _cout_mutex; // mutable для использования в const-методах
+        // Ключ ChaCha20 всех потоков генератора: из seed или 256 бит системной энтропии
+        std::array<uint32_t, 8> _key;
+        // Каждое простое ищется от своей стартовой точки: номер потока кандидатов для следующего поиска
+        uint64_t _next_prime_stream = 0;
+        // Потоки, не связанные с поиском простых (выбор e и d), нумеруются с конца
+        uint64_t _next_aux_stream = UINT64_MAX;
+        unsigned _num_threads = 0;
+        bool _verbose = true;
     };
 
 public:
-    RsaService(PrimalityTestType type, double probability, int bit_length);
+    // С seed ключи воспроизводимы: одинаковый seed дает одинаковую последовательность ключей
+    RsaService(PrimalityTestType type, double probability, int bit_length,
+               std::optional<uint64_t> seed = std::nullopt);
+    // Ключ берется из пула готовых ключей (см. RsaKeyPool); поиск простых в конструкторе не выполняется,
+    // если в пуле есть ключ нужной длины
+    RsaService(RsaKeyPool& pool, PrimalityTestType type, int bit_length);
+    // Число потоков поиска простых при генерации ключей (0 - по числу ядер)
+    void SetKeyGenerationThreads(unsigned threads) { _keyGenerator.SetThreadCount(threads); }
+    // Печатать ли ход генерации ключей в std::cout
+    void SetKeyGenerationVerbose(bool verbose) { _keyGenerator.SetVerbose(verbose); }
     big_int Encrypt(const big_int& message) const;
     big_int Decrypt(const big_int& ciphertext) const;
+    // Пакетная обработка: элементы делятся на непрерывные диапазоны по числу ядер,
+    // все потоки используют общие контексты Монтгомери и параметры КТО; порядок результатов сохраняется
+    std::vector<big_int> EncryptBatch(const std::vector<big_int>& messages) const;
+    std::vector<big_int> DecryptBatch(const std::vector<big_int>& ciphertexts) const;
+    big_int Sign(const big_int& message) const;
+    bool Verify(const big_int& message, const big_int& signature) const;
+    // Считать m^dp mod p и m^dq mod q в двух потоках (меньше задержка одной операции)
+    void SetParallelCrt(bool enabled) { _parallel_crt = enabled; }
     RsaPublicKey GetPublicKey() const { return _publicKey; }
     RsaPrivateKey GetPrivateKey() const { return _privateKey; }
 
 private:
+    friend class RsaKeyPool;
+
+    void _install_key_pair(const std::pair<RsaPublicKey, RsaPrivateKey>& key_pair);
+    // Пересчитывает данные, зависящие только от ключа (контексты Монтгомери, цепочка для e)
+    void _update_key_precomputation();
+    // x^d mod n: по КТО со сборкой Гарнера, если известны p и q
+    big_int _private_operation(const big_int& x, bool allow_parallel = true) const;
+    template <typename Operation>
+    static std::vector<big_int> _run_batch(const std::vector<big_int>& input, Operation operation);
+
     KeyGenerator _keyGenerator;
     RsaPublicKey _publicKey;
     RsaPrivateKey _privateKey;
+    std::shared_ptr<const MontgomeryContext> _montgomery;
+    std::shared_ptr<const ExponentChain> _public_exponent_chain;
+    std::shared_ptr<const MontgomeryContext> _montgomery_p;
+    std::shared_ptr<const MontgomeryContext> _montgomery_q;
+    bool _parallel_crt = false;
 };
 
 #endif //RSA_SERVICE_H
\ No newline at end of file
@@ -5,27 +5,96 @@
 #include "StatelessService.h"
 #include <stdexcept>
 #include <utility>
+#include <vector>
+#include <algorithm>
 
 
-big_int CryptoService::ModPow(big_int base, big_int exp, const big_int& mod) {
+namespace {
+    // Ширина окна по длине показателя (Menezes et al., HAC 14.85)
+    unsigned window_size(unsigned bits) {
+        if (bits > 671) return 6;
+        if (bits > 239) return 5;
+        if (bits > 79) return 4;
+        if (bits > 23) return 3;
+        return 1;
+    }
+}
+
+big_int CryptoService::ModPow(big_int base, big_int exp, const big_int& mod, ModPowMethod method) {
     if (mod == 0) {
         throw std::invalid_argument("Модуль не может быть нулевым");
     }
     if (exp < 0) {
         throw std::invalid_argument("Степень не может быть отрицательной");
     }
+    if (exp == 0) {
+        return big_int(1);
+    }
 
-    big_int result(1);
     base = (base % mod + mod) % mod;
 
-    while (exp != 0) {
-        if (exp % big_int(2) == big_int(1)) {
-            result = (result * base) % mod;
+    if (method == ModPowMethod::GMP || (method == ModPowMethod::GMP_SEC && mpz_odd_p(mod.backend().data()) == 0)) {
+        big_int result;
+        mpz_powm(result.backend().data(), base.backend().data(), exp.backend().data(), mod.backend().data());
+        return result;
+    }
+    if (method == ModPowMethod::GMP_SEC) {
+        big_int result;
+        mpz_powm_sec(result.backend().data(), base.backend().data(), exp.backend().data(), mod.backend().data());
+        return result;
+    }
+
+    // Скользящее окно слева направо: биты читаются прямо из лимбов показателя
+    const unsigned bits = boost::multiprecision::msb(exp) + 1;
+    const unsigned k = window_size(bits);
+
+    // odd_powers[i] = base^(2i+1) mod m
+    std::vector<big_int> odd_powers(std::size_t(1) << (k - 1));
+    odd_powers[0] = base;
+    if (odd_powers.size() > 1) {
+        big_int base_sq = base * base;
+        base_sq %= mod;
+        for (std::size_t i = 1; i < odd_powers.size(); ++i) {
+            odd_powers[i] = odd_powers[i - 1] * base_sq;
+            odd_powers[i] %= mod;
+        }
+    }
+
+    big_int result(1);
+    bool started = false;
+    long i = static_cast<long>(bits) - 1;
+    while (i >= 0) {
+        if (!boost::multiprecision::bit_test(exp, static_cast<unsigned>(i))) {
+            if (started) {
+                result *= result;
+                result %= mod;
+            }
+            --i;
+            continue;
         }
-        exp >>= 1;
-        base = (base * base) % mod;
+        // окно [j, i] длиной не больше k, заканчивающееся единичным битом
+        long j = std::max(i - static_cast<long>(k) + 1, 0L);
+        while (!boost::multiprecision::bit_test(exp, static_cast<unsigned>(j))) {
+            ++j;
+        }
+        unsigned value = 0;
+        for (long t = i; t >= j; --t) {
+            value = (value << 1) | (boost::multiprecision::bit_test(exp, static_cast<unsigned>(t)) ? 1u : 0u);
+        }
+        if (started) {
+            for (long t = i; t >= j; --t) {
+                result *= result;
+                result %= mod;
+            }
+            result *= odd_powers[value >> 1];
+            result %= mod;
+        } else {
+            result = odd_powers[value >> 1];
+            started = true;
+        }
+        i = j - 1;
     }
-    return result;
+    return result % mod;
 }
 
 int CryptoService::LegendreSymbol(const big_int& a, const big_int& p) {
@@ -36,71 +105,168 @@ int CryptoService::LegendreSymbol(const big_int& a, const big_int& p) {
 }
 
 int CryptoService::JacobiSymbol(big_int a, big_int n) {
-    if (n <= big_int(0) || n % big_int(2) == big_int(0)) {
+    if (n <= 0 || mpz_even_p(n.backend().data())) {
         throw std::invalid_argument("n должно быть положительным нечетным числом");
     }
-    if (Gcd(a, n) != big_int(1)) {
-        return 0;
-    }
 
+    mpz_ptr x = a.backend().data();
+    mpz_ptr m = n.backend().data();
     int r = 1;
-    if (a < 0) {
-        a = -a;
-        if (n % big_int(4) == big_int(3)) {
+    // (-1/n) = -1 при n = 3 (mod 4)
+    if (mpz_sgn(x) < 0) {
+        mpz_neg(x, x);
+        if ((mpz_getlimbn(m, 0) & 3) == 3) {
             r = -r;
         }
     }
+    if (mpz_cmp(x, m) >= 0) {
+        mpz_tdiv_r(x, x, m);
+    }
 
-    a %= n;
-
-    while (a != 0) {
-        int t = 0;
-        while (a % big_int(2) == big_int(0)) {
-            t++;
-            a /= big_int(2);
+    // Бинарный алгоритм: двойки снимаются сдвигом, остальное - вычитание и квадратичный закон взаимности;
+    // вычеты по модулю 4 и 8 читаются из младшего лимба. Общий делитель проявится как n != 1 в конце
+    while (mpz_sgn(x) != 0) {
+        const mp_bitcnt_t t = mpz_scan1(x, 0);
+        if (t > 0) {
+            mpz_tdiv_q_2exp(x, x, t);
+            const mp_limb_t n_mod_8 = mpz_getlimbn(m, 0) & 7;
+            if ((t & 1) && (n_mod_8 == 3 || n_mod_8 == 5)) {
+                r = -r;
+            }
         }
-
-        if (t % 2 == 1) {
-            big_int n_mod_8 = n % big_int(8);
-            if (n_mod_8 == big_int(3) || n_mod_8 == big_int(5)) {
+        if (mpz_cmp(x, m) < 0) {
+            if ((mpz_getlimbn(x, 0) & 3) == 3 && (mpz_getlimbn(m, 0) & 3) == 3) {
                 r = -r;
             }
+            mpz_swap(x, m);
         }
+        mpz_sub(x, x, m);
+    }
 
-        if (a % big_int(4) == big_int(3) && n % big_int(4) == big_int(3)) {
-            r = -r;
+    return mpz_cmp_ui(m, 1) == 0 ? r : 0;
+}
+
+namespace {
+    // r = a*A + b*B для одноразрядных знаковых коэффициентов
+    void linear_combination(mpz_t r, const mpz_t a, long A, const mpz_t b, long B) {
+        mpz_mul_si(r, a, A);
+        if (B >= 0) {
+            mpz_addmul_ui(r, b, static_cast<unsigned long>(B));
+        } else {
+            mpz_submul_ui(r, b, -static_cast<unsigned long>(B));
         }
-        std::swap(a, n);
-        a %= n;
     }
 
-    return r;
+    mp_limb_t word_gcd(mp_limb_t a, mp_limb_t b) {
+        if (a == 0) return b;
+        if (b == 0) return a;
+        const int shift = __builtin_ctzll(a | b);
+        a >>= __builtin_ctzll(a);
+        while (b != 0) {
+            b >>= __builtin_ctzll(b);
+            if (a > b) {
+                std::swap(a, b);
+            }
+            b -= a;
+        }
+        return a << shift;
+    }
 }
 
 big_int CryptoService::Gcd(big_int a, big_int b) {
-    using boost::multiprecision::abs;
-    a = abs(a);
-    b = abs(b);
+    mpz_ptr x = a.backend().data();
+    mpz_ptr y = b.backend().data();
+    mpz_abs(x, x);
+    mpz_abs(y, y);
+    if (mpz_cmp(x, y) < 0) {
+        mpz_swap(x, y);
+    }
+
+    // Лемер: пока y многолимбовое, шаги Евклида делаются над старшими 63 битами x и y,
+    // накопленная матрица 2x2 применяется к полным числам одной линейной комбинацией
+    big_int t;
+    big_int u;
+    mpz_ptr tz = t.backend().data();
+    mpz_ptr uz = u.backend().data();
+    while (mpz_size(y) > 1) {
+        const size_t shift = mpz_sizeinbase(x, 2) - 63;
+        mpz_tdiv_q_2exp(tz, x, shift);
+        __int128 xh = static_cast<__int128>(mpz_get_ui(tz));
+        mpz_tdiv_q_2exp(tz, y, shift);
+        __int128 yh = static_cast<__int128>(mpz_get_ui(tz));
 
-    while (b != 0) {
-        a %= b;
-        std::swap(a, b);
+        __int128 A = 1, B = 0, C = 0, D = 1;
+        while (yh + C != 0 && yh + D != 0) {
+            const __int128 q = (xh + A) / (yh + C);
+            if (q != (xh + B) / (yh + D)) {
+                break;
+            }
+            __int128 tmp = A - q * C; A = C; C = tmp;
+            tmp = B - q * D; B = D; D = tmp;
+            tmp = xh - q * yh; xh = yh; yh = tmp;
+        }
+
+        if (B == 0) {
+            // старшие разряды ничего не дали - обычный шаг деления
+            mpz_tdiv_r(tz, x, y);
+            mpz_swap(x, y);
+            mpz_swap(y, tz);
+        } else {
+            linear_combination(tz, x, static_cast<long>(A), y, static_cast<long>(B));
+            linear_combination(uz, x, static_cast<long>(C), y, static_cast<long>(D));
+            mpz_swap(x, tz);
+            mpz_swap(y, uz);
+        }
+    }
+
+    if (mpz_sgn(y) == 0) {
+        return a;
     }
-    return a;
+    const mp_limb_t y_word = mpz_getlimbn(y, 0);
+    return big_int(word_gcd(mpz_tdiv_ui(x, y_word), y_word));
 }
 
 big_int CryptoService::ExtendedGcd(big_int a, big_int b, big_int& x, big_int& y) {
     if (a == 0) {
         x = big_int(0);
-        y = big_int(1);
-        return b;
+        y = big_int(b < 0 ? -1 : 1);
+        return abs(b);
     }
 
-    big_int x1, y1;
-    big_int gcd = ExtendedGcd(b % a, a, x1, y1);
-
-    x = y1 - (b / a) * x1;
-    y = x1;
+    // Итеративный Евклид по парам (b, a): в каждой паре хранится только коэффициент при a,
+    // обе пары обновляются на месте; коэффициент при b восстанавливается в конце делением
+    big_int r0 = b;
+    big_int r1 = a;
+    big_int x0 = 0;
+    big_int x1 = 1;
+    big_int q;
+    big_int tmp;
+    mpz_ptr r0z = r0.backend().data();
+    mpz_ptr r1z = r1.backend().data();
+    mpz_ptr x0z = x0.backend().data();
+    mpz_ptr x1z = x1.backend().data();
+    while (mpz_sgn(r1z) != 0) {
+        mpz_tdiv_qr(q.backend().data(), tmp.backend().data(), r0z, r1z);
+        mpz_swap(r0z, r1z);
+        mpz_swap(r1z, tmp.backend().data());
+        mpz_submul(x0z, q.backend().data(), x1z);
+        mpz_swap(x0z, x1z);
+    }
 
-    return gcd;
-}
\ No newline at end of file
+    // r0 = a*x0 + b*y
+    x = x0;
+    if (b == 0) {
+        y = big_int(0);
+    } else {
+        mpz_mul(tmp.backend().data(), a.backend().data(), x0z);
+        mpz_sub(tmp.backend().data(), r0z, tmp.backend().data());
+        mpz_divexact(y.backend().data(), tmp.backend().data(), b.backend().data());
+    }
+    // При отрицательных входах остатки усечённого деления могут оставить НОД со знаком минус
+    if (mpz_sgn(r0z) < 0) {
+        mpz_neg(r0z, r0z);
+        x = -x;
+        y = -y;
+    }
+    return r0;
+}
@@ -32,7 +32,7 @@ public:
     static int LegendreSymbol(const big_int& a, const big_int& p);
 
     /**
-     * @brief Вычисляет символ Якоби (a/n).
+     * @brief Вычисляет символ Якоби (a/n) бинарным алгоритмом, без отдельного вычисления НОД.
      * @param a Целое число.
      * @param n Положительное нечетное целое число.
      * @return 0, 1 или -1 в зависимости от свойств чисел.
@@ -41,7 +41,7 @@ public:
 
     /**
      * @brief Вычисляет Наибольший Общий Делитель (НОД) двух целых чисел
-     *        с помощью алгоритма Евклида.
+     *        алгоритмом Лемера (шаги Евклида по старшим словам), последнее слово - бинарным НОД.
      * @param a Первое число.
      * @param b Второе число.
      * @return НОД(a, b).
@@ -50,24 +50,31 @@ public:
 
     /**
      * @brief Находит НОД и решает диофантово уравнение ax + by = gcd(a, b)
-     *        с помощью расширенного алгоритма Евклида.
+     *        с помощью расширенного алгоритма Евклида (итеративно, без рекурсии).
      * @param a Первое число.
      * @param b Второе число.
      * @param x Ссылка для возврата первого коэффициента Безу.
      * @param y Ссылка для возврата второго коэффициента Безу.
-     * @return НОД(a, b).
+     * @return НОД(a, b) >= 0 при любых знаках a и b.
      */
     static big_int ExtendedGcd(big_int a, big_int b, big_int& x, big_int& y);
 
     /**
-     * @brief Выполняет операцию возведения в степень по модулю (base^exp % mod)
-     *        с помощью алгоритма бинарного возведения в степень.
+     * @brief Способ возведения в степень по модулю.
+     *        SLIDING_WINDOW - скользящее окно с таблицей нечетных степеней;
+     *        GMP - mpz_powm; GMP_SEC - mpz_powm_sec (постоянное время, только для нечетного модуля).
+     */
+    enum class ModPowMethod { SLIDING_WINDOW, GMP, GMP_SEC };
+
+    /**
+     * @brief Выполняет операцию возведения в степень по модулю (base^exp % mod).
      * @param base Основание.
      * @param exp Показатель степени.
      * @param mod Модуль.
+     * @param method Реализация; по умолчанию - скользящее окно.
      * @return Результат (base^exp) % mod.
      */
-    static big_int ModPow(big_int base, big_int exp, const big_int& mod);
+    static big_int ModPow(big_int base, big_int exp, const big_int& mod, ModPowMethod method = ModPowMethod::SLIDING_WINDOW);
 };
 
 
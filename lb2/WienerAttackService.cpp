@@ -4,95 +4,196 @@
 
 #include "WienerAttackService.h"
 #include "StatelessService.h"
+#include <algorithm>
+#include <future>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+    // Квадратичные вычеты по модулям 64, 63, 65, 11 (64 * 63 * 65 * 11 = 2882880 < 2^32):
+    // неквадрат отсеивается с вероятностью около 99%, до извлечения корня
+    struct SquareResidues {
+        bool mod64[64] = {};
+        bool mod63[63] = {};
+        bool mod65[65] = {};
+        bool mod11[11] = {};
+
+        SquareResidues() {
+            for (unsigned i = 0; i < 64; ++i) mod64[(i * i) % 64] = true;
+            for (unsigned i = 0; i < 63; ++i) mod63[(i * i) % 63] = true;
+            for (unsigned i = 0; i < 65; ++i) mod65[(i * i) % 65] = true;
+            for (unsigned i = 0; i < 11; ++i) mod11[(i * i) % 11] = true;
+        }
+    };
+    const SquareResidues g_square_residues;
 
-static big_int integer_sqrt(const big_int& n) {
-    if (n < 0) {
-        return 0;
-    }
-    if (n == 0) {
-        return 0;
-    }
-    big_int x = n, y = (x + 1) / 2;
-    while (y < x) {
-        x = y;
-        y = (x + n / x) / 2;
-    }
-    return x;
-}
-
-std::vector<big_int> WienerAttackService::_calculate_continued_fraction(big_int e, big_int n) {
-    std::vector<big_int> coefficients;
-    while (e != 0) {
-        coefficients.push_back(n / e);
-        big_int remainder = n % e;
-        n = e;
-        e = remainder;
+    // root = sqrt(x), если x >= 0 - полный квадрат; вычет по модулю 64 берется из младшего лимба
+    bool perfect_square_root(mpz_srcptr x, mpz_ptr root, mpz_ptr remainder) {
+        if (!g_square_residues.mod64[mpz_getlimbn(x, 0) & 63]) {
+            return false;
+        }
+        const unsigned long r = mpz_fdiv_ui(x, 64UL * 63 * 65 * 11);
+        if (!g_square_residues.mod63[r % 63] || !g_square_residues.mod65[r % 65] || !g_square_residues.mod11[r % 11]) {
+            return false;
+        }
+        mpz_sqrtrem(root, remainder, x);
+        return mpz_sgn(remainder) == 0;
     }
-    return coefficients;
 }
 
 std::optional<big_int> WienerAttackService::_test_candidate(const big_int& e, const big_int& n, const big_int& k, const big_int& d) {
-    if (d == 0 || d % 2 == 0) {
+    // e*d = 1 (mod phi), а phi четно, поэтому d нечетно
+    if (k == 0 || mpz_even_p(d.backend().data())) {
         return std::nullopt;
     }
 
-    if ((e * d - 1) % k != 0) {
+    // phi = (e*d - 1) / k, e*d - 1 считается один раз
+    big_int phi = e * d;
+    mpz_ptr phi_z = phi.backend().data();
+    mpz_sub_ui(phi_z, phi_z, 1);
+    if (!mpz_divisible_p(phi_z, k.backend().data())) {
         return std::nullopt;
     }
+    mpz_divexact(phi_z, phi_z, k.backend().data());
 
-    big_int phi = (e * d - 1) / k;
+    // p и q - корни x^2 - b*x + n, b = n - phi + 1
     big_int b = n - phi + 1;
-
-    big_int discriminant = b * b - 4 * n;
-
-    if (discriminant < 0) {
+    big_int discriminant = b * b;
+    mpz_ptr disc_z = discriminant.backend().data();
+    mpz_submul_ui(disc_z, n.backend().data(), 4);
+    if (mpz_sgn(disc_z) < 0) {
         return std::nullopt;
     }
 
-    big_int root_d = integer_sqrt(discriminant);
-    if (root_d * root_d != discriminant) {
+    big_int root;
+    big_int remainder;
+    if (!perfect_square_root(disc_z, root.backend().data(), remainder.backend().data())) {
         return std::nullopt;
     }
-    if ((b + root_d) % 2 != 0) {
+    if (mpz_even_p(b.backend().data()) != mpz_even_p(root.backend().data())) {
         return std::nullopt;
     }
     return phi;
 }
 
 WienerAttackResult WienerAttackService::Attack(const RsaPublicKey& publicKey) {
+    return Attack(publicKey, true);
+}
+
+WienerAttackResult WienerAttackService::Attack(const RsaPublicKey& publicKey, bool store_convergents) {
     WienerAttackResult result;
     result.success = false;
 
-    std::vector<big_int> cf = _calculate_continued_fraction(publicKey.e, publicKey.n);
+    // Разложение e/n строится по ходу перебора: подходящие дроби сразу имеют вид k/d, поэтому каждую
+    // достаточно проверить один раз (у разложения n/e те же дроби, только перевернутые)
+    big_int numerator = publicKey.e;
+    big_int denominator = publicKey.n;
+    big_int coeff;
+    big_int remainder;
 
     big_int pk_2 = 0, pk_1 = 1;
     big_int qk_2 = 1, qk_1 = 0;
 
-    for (const auto& coeff : cf) {
-        big_int pk = coeff * pk_1 + pk_2;
-        big_int qk = coeff * qk_1 + qk_2;
-
-        result.convergents.push_back({pk, qk});
-        auto phi_opt1 = _test_candidate(publicKey.e, publicKey.n, pk, qk);
-        if (phi_opt1.has_value()) {
+    if (store_convergents && publicKey.e > publicKey.n) {
+        // n/e = [0; ...] - разложение e/n этой дроби не дает
+        result.convergents.push_back({big_int(0), big_int(1)});
+    }
+    while (denominator != 0) {
+        mpz_tdiv_qr(coeff.backend().data(), remainder.backend().data(),
+                    numerator.backend().data(), denominator.backend().data());
+        numerator.swap(denominator);
+        denominator.swap(remainder);
+
+        // p_k = a_k * p_(k-1) + p_(k-2) на месте p_(k-2), затем сдвиг
+        mpz_addmul(pk_2.backend().data(), coeff.backend().data(), pk_1.backend().data());
+        mpz_addmul(qk_2.backend().data(), coeff.backend().data(), qk_1.backend().data());
+        pk_1.swap(pk_2);
+        qk_1.swap(qk_2);
+        const big_int& pk = pk_1;
+        const big_int& qk = qk_1;
+
+        // В result - подходящие дроби n/e, как и до перехода на разложение e/n: пары перевернуты,
+        // а 0/1 от нулевого первого коэффициента (при e < n) в разложении n/e отсутствует
+        if (store_convergents && !pk.is_zero()) {
+            result.convergents.push_back({qk, pk});
+        }
+        auto phi_opt = _test_candidate(publicKey.e, publicKey.n, pk, qk);
+        if (phi_opt.has_value()) {
             result.success = true;
             result.found_d = qk;
-            result.found_phi = phi_opt1.value();
+            result.found_phi = phi_opt.value();
             return result;
         }
+    }
 
-        auto phi_opt2 = _test_candidate(publicKey.e, publicKey.n, qk, pk);
-        if (phi_opt2.has_value()) {
-            result.success = true;
-            result.found_d = pk;
-            result.found_phi = phi_opt2.value();
-            return result;
+    return result;
+}
+
+void WienerAttackService::_scan_range(const std::vector<RsaPublicKey>& keys, size_t begin, size_t end,
+                                      size_t first_index, std::vector<WienerScanHit>& hits) {
+    for (size_t i = begin; i < end; ++i) {
+        WienerAttackResult result = Attack(keys[i], false);
+        if (result.success) {
+            hits.push_back({first_index + i, keys[i], std::move(result)});
         }
-        pk_2 = pk_1;
-        qk_2 = qk_1;
-        pk_1 = pk;
-        qk_1 = qk;
     }
+}
 
-    return result;
-}
\ No newline at end of file
+std::vector<WienerScanHit> WienerAttackService::_scan_batch(const std::vector<RsaPublicKey>& keys, size_t first_index,
+                                                            unsigned threads) {
+    const size_t num_threads = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+    const size_t chunk_size = (keys.size() + num_threads - 1) / num_threads;
+    std::vector<WienerScanHit> hits;
+    if (chunk_size == 0) {
+        return hits;
+    }
+
+    // у каждого потока свой список найденных, затем они склеиваются по порядку диапазонов
+    std::vector<std::vector<WienerScanHit>> partial((keys.size() + chunk_size - 1) / chunk_size);
+    std::vector<std::future<void>> futures;
+    for (size_t part = 1; part < partial.size(); ++part) {
+        const size_t begin = part * chunk_size;
+        const size_t end = std::min(begin + chunk_size, keys.size());
+        futures.push_back(std::async(std::launch::async, &WienerAttackService::_scan_range, std::cref(keys),
+                                     begin, end, first_index, std::ref(partial[part])));
+    }
+    _scan_range(keys, 0, std::min(chunk_size, keys.size()), first_index, partial[0]);
+    for (auto& fut : futures) {
+        fut.get();
+    }
+    for (auto& part : partial) {
+        std::move(part.begin(), part.end(), std::back_inserter(hits));
+    }
+    return hits;
+}
+
+std::vector<WienerScanHit> WienerAttackService::Scan(const std::vector<RsaPublicKey>& keys, unsigned threads) {
+    return _scan_batch(keys, 0, threads);
+}
+
+std::vector<WienerScanHit> WienerAttackService::Scan(std::istream& input, unsigned threads) {
+    std::vector<WienerScanHit> hits;
+    std::vector<RsaPublicKey> batch;
+    std::vector<RsaPublicKey> next_batch;
+    size_t line_number = 0;
+    size_t first_index = 0;
+    bool has_batch = ReadPublicKeys(input, batch, SCAN_BATCH_SIZE, line_number);
+    while (has_batch) {
+        auto batch_hits = std::async(std::launch::async, &WienerAttackService::_scan_batch, std::cref(batch),
+                                     first_index, threads);
+        bool has_next;
+        try {
+            has_next = ReadPublicKeys(input, next_batch, SCAN_BATCH_SIZE, line_number);
+        } catch (...) {
+            batch_hits.wait();
+            throw;
+        }
+        std::vector<WienerScanHit> found = batch_hits.get();
+        std::move(found.begin(), found.end(), std::back_inserter(hits));
+        first_index += batch.size();
+        batch.swap(next_batch);
+        has_batch = has_next;
+    }
+    return hits;
+}
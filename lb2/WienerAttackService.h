@@ -8,13 +8,22 @@
 #include "RsaService.h" // Нужен для RsaPublicKey
 #include <vector>
 #include <optional>
+#include <istream>
 
 // Структура для хранения результатов атаки
 struct WienerAttackResult {
     bool success;                   // Успешна ли была атака
     big_int found_d;                // Найденная секретная экспонента d
     big_int found_phi;              // Найденное значение функции Эйлера phi(n)
-    std::vector<std::pair<big_int, big_int>> convergents; // Коллекция подходящих дробей (k/d)
+    // Подходящие дроби разложения n/e в порядке перебора: пары {числитель, знаменатель} = {d, k}
+    std::vector<std::pair<big_int, big_int>> convergents;
+};
+
+// Найденный при пакетной проверке уязвимый ключ
+struct WienerScanHit {
+    size_t index;                   // номер ключа во входных данных (с нуля)
+    RsaPublicKey key;
+    WienerAttackResult result;
 };
 
 class WienerAttackService {
@@ -27,15 +36,34 @@ public:
      * @return Структура WienerAttackResult с результатами атаки.
      */
     static WienerAttackResult Attack(const RsaPublicKey& publicKey);
+    /**
+     * @param store_convergents Сохранять ли подходящие дроби в result.convergents.
+     */
+    static WienerAttackResult Attack(const RsaPublicKey& publicKey, bool store_convergents);
 
-private:
     /**
-     * @brief Вычисляет коэффициенты непрерывной дроби для e/n.
-     * @param e Открытая экспонента.
-     * @param n Модуль.
-     * @return Вектор с коэффициентами.
+     * @brief Пакетная проверка: ключи делятся между потоками, возвращаются только уязвимые,
+     *        в порядке исходных индексов. Подходящие дроби не сохраняются.
+     * @param threads Число потоков (0 - по числу ядер).
      */
-    static std::vector<big_int> _calculate_continued_fraction(big_int e, big_int n);
+    static std::vector<WienerScanHit> Scan(const std::vector<RsaPublicKey>& keys, unsigned threads = 0);
+
+    /**
+     * @brief Пакетная проверка ключей из потока: по строке "n e" на ключ (десятичные числа
+     *        или шестнадцатеричные с префиксом 0x); пустые строки и строки с '#' пропускаются.
+     *        Ключи читаются порциями, следующая порция читается, пока обрабатывается текущая.
+     * @throws std::invalid_argument при некорректной строке (с ее номером).
+     */
+    static std::vector<WienerScanHit> Scan(std::istream& input, unsigned threads = 0);
+
+private:
+    static constexpr size_t SCAN_BATCH_SIZE = 4096;
+
+    // Проверяет ключи keys[begin, end), найденные добавляются в hits с индексом first_index + i
+    static void _scan_range(const std::vector<RsaPublicKey>& keys, size_t begin, size_t end,
+                            size_t first_index, std::vector<WienerScanHit>& hits);
+    static std::vector<WienerScanHit> _scan_batch(const std::vector<RsaPublicKey>& keys, size_t first_index,
+                                                  unsigned threads);
 
     /**
      * @brief Проверяет, является ли кандидат d правильной секретной экспонентой.
@@ -0,0 +1,353 @@
+//
+// Замеры теоретико-числового слоя и RSA по длинам 256..8192 бит: ModPow (все методы), Gcd, ExtendedGcd,
+// JacobiSymbol, одна итерация каждого теста простоты, GeneratePrime, GenerateKeys,
+// Encrypt/Decrypt и атака Винера. Каждый замер - выборка отдельных вызовов на входах из seed;
+// время генерации ключей случайно, поэтому в JSON - медиана, p90 и p99, а не среднее.
+//
+// Запуск: rsa_bench [--filter подстрока] [--seed N] [--samples N] [--max-time сек] [--max-bits 8192]
+//                   [--max-key-bits 2048] [--keygen-runs N] [--threads N] [--out файл.json]
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "ChaCha20Random.h"
+#include "PrimalityTest.h"
+#include "RsaService.h"
+#include "WienerAttackService.h"
+
+namespace {
+    struct BenchOptions {
+        std::string filter;
+        uint64_t seed = 20251026;
+        size_t samples = 101;          // наибольшее число вызовов на замер
+        double max_time = 1.0;         // после этого времени замер останавливается (но не раньше MIN_SAMPLES)
+        int max_bits = 8192;           // длины операндов: 256, 512, ..., max_bits
+        int max_key_bits = 2048;       // длины модуля для генерации ключей и Encrypt/Decrypt
+        size_t keygen_runs = 11;       // вызовов GeneratePrime и GenerateKeys подряд по seed
+        unsigned threads = 1;          // потоки поиска простых
+        std::string out;
+    };
+
+    constexpr size_t MIN_SAMPLES = 5;
+    constexpr double PROBABILITY = 0.999; // целевая вероятность тестов простоты при генерации ключей
+
+    struct BenchResult {
+        std::string name;
+        int bits;
+        std::vector<double> ns;        // по возрастанию
+    };
+
+    template <typename Body>
+    double time_ns(Body body) {
+        const auto start = std::chrono::steady_clock::now();
+        body();
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Процентиль по ближайшему рангу
+    double percentile(const std::vector<double>& sorted, double q) {
+        const size_t rank = static_cast<size_t>(std::ceil(q * static_cast<double>(sorted.size())));
+        return sorted[std::max<size_t>(rank, 1) - 1];
+    }
+
+    class BenchRunner {
+    public:
+        explicit BenchRunner(const BenchOptions& options) : m_options(options) {}
+
+        bool selected(const std::string& name) const {
+            return m_options.filter.empty() || name.find(m_options.filter) != std::string::npos;
+        }
+
+        // sample(i) готовит входы i-й выборки и возвращает время замеряемой части в нс
+        void run(const std::string& name, int bits, const std::function<double(size_t)>& sample) {
+            run(name, bits, m_options.samples, true, sample);
+        }
+
+        // Ровно count выборок без ограничения по времени (для выборок по seed)
+        void run_fixed(const std::string& name, int bits, size_t count, const std::function<double(size_t)>& sample) {
+            run(name, bits, count, false, sample);
+        }
+
+        void write_json(std::ostream& out) const {
+            out << "{\n  \"context\": {\n";
+            out << "    \"seed\": " << m_options.seed << ",\n";
+            out << "    \"samples\": " << m_options.samples << ",\n";
+            out << "    \"max_time\": " << m_options.max_time << ",\n";
+            out << "    \"keygen_runs\": " << m_options.keygen_runs << ",\n";
+            out << "    \"threads\": " << m_options.threads << "\n";
+            out << "  },\n  \"benchmarks\": [";
+            for (size_t i = 0; i < m_results.size(); ++i) {
+                const BenchResult& r = m_results[i];
+                double total = 0;
+                for (double ns : r.ns) total += ns;
+                out << (i ? ",\n" : "\n") << "    {\"name\": \"" << r.name << "\""
+                    << ", \"bits\": " << r.bits
+                    << ", \"samples\": " << r.ns.size()
+                    << ", \"median_ns\": " << percentile(r.ns, 0.5)
+                    << ", \"p90_ns\": " << percentile(r.ns, 0.9)
+                    << ", \"p99_ns\": " << percentile(r.ns, 0.99)
+                    << ", \"mean_ns\": " << total / static_cast<double>(r.ns.size())
+                    << ", \"min_ns\": " << r.ns.front()
+                    << ", \"max_ns\": " << r.ns.back() << "}";
+            }
+            out << "\n  ]\n}\n";
+        }
+
+    private:
+        void run(const std::string& name, int bits, size_t count, bool time_limited,
+                 const std::function<double(size_t)>& sample) {
+            const std::string full_name = name + "/" + std::to_string(bits);
+            if (!selected(full_name)) {
+                return;
+            }
+            BenchResult result{full_name, bits, {}};
+            double total = 0;
+            for (size_t i = 0; i < count; ++i) {
+                const double ns = sample(i);
+                result.ns.push_back(ns);
+                total += ns;
+                if (time_limited && result.ns.size() >= MIN_SAMPLES && total > m_options.max_time * 1e9) {
+                    break;
+                }
+            }
+            std::sort(result.ns.begin(), result.ns.end());
+            std::cerr << full_name << ": " << result.ns.size() << " samples, median "
+                      << percentile(result.ns, 0.5) / 1e3 << " us" << std::endl;
+            m_results.push_back(std::move(result));
+        }
+
+        const BenchOptions& m_options;
+        std::vector<BenchResult> m_results;
+    };
+
+    big_int random_bits(ChaCha20Random& rng, int bits) {
+        return rng.Uniform(big_int(1) << (bits - 1), (big_int(1) << bits) - 1);
+    }
+
+    big_int random_odd_bits(ChaCha20Random& rng, int bits) {
+        big_int value = random_bits(rng, bits);
+        mpz_setbit(value.backend().data(), 0);
+        return value;
+    }
+
+    bool is_small_prime(int value) {
+        if (value < 2) return false;
+        for (int d = 2; d * d <= value; ++d) {
+            if (value % d == 0) return false;
+        }
+        return true;
+    }
+
+    // 2^p - 1 для наибольшего простого p <= bits. Составное число Мерсенна с простым p - сильное
+    // псевдопростое по основанию 2, поэтому итерация Бэйли-PSW доходит до теста Люка, как на простом;
+    // для остальных тестов время итерации от простоты n не зависит. Поиск настоящего простого
+    // длиной 8192 бит занял бы минуты.
+    big_int iteration_modulus(int bits) {
+        int p = bits;
+        while (!is_small_prime(p)) --p;
+        return (big_int(1) << p) - 1;
+    }
+
+    // Открывает PerformSingleIteration теста для замера одной итерации
+    template <typename Test>
+    class SingleIteration : public Test {
+    public:
+        using Test::PerformSingleIteration;
+    };
+
+    std::vector<int> bit_sizes(int max_bits) {
+        std::vector<int> sizes;
+        for (int bits = 256; bits <= max_bits; bits *= 2) {
+            sizes.push_back(bits);
+        }
+        return sizes;
+    }
+
+    void bench_number_theory(BenchRunner& runner, const BenchOptions& options) {
+        const std::pair<CryptoService::ModPowMethod, const char*> methods[] = {
+                {CryptoService::ModPowMethod::SLIDING_WINDOW, "SLIDING_WINDOW"},
+                {CryptoService::ModPowMethod::GMP, "GMP"},
+                {CryptoService::ModPowMethod::GMP_SEC, "GMP_SEC"},
+        };
+        for (int bits : bit_sizes(options.max_bits)) {
+            for (const auto& [method, method_name] : methods) {
+                ChaCha20Random rng(options.seed, static_cast<uint64_t>(bits));
+                runner.run(std::string("ModPow/") + method_name, bits, [&](size_t) {
+                    const big_int mod = random_odd_bits(rng, bits);
+                    const big_int base = rng.Uniform(2, mod - 1);
+                    const big_int exp = random_bits(rng, bits);
+                    big_int result;
+                    const double ns = time_ns([&] { result = CryptoService::ModPow(base, exp, mod, method); });
+                    return ns;
+                });
+            }
+
+            ChaCha20Random rng(options.seed, static_cast<uint64_t>(bits) + 1);
+            runner.run("Gcd", bits, [&](size_t) {
+                const big_int a = random_bits(rng, bits);
+                const big_int b = random_bits(rng, bits);
+                big_int result;
+                return time_ns([&] { result = CryptoService::Gcd(a, b); });
+            });
+            runner.run("ExtendedGcd", bits, [&](size_t) {
+                const big_int a = random_bits(rng, bits);
+                const big_int b = random_bits(rng, bits);
+                big_int x, y, result;
+                return time_ns([&] { result = CryptoService::ExtendedGcd(a, b, x, y); });
+            });
+            runner.run("JacobiSymbol", bits, [&](size_t) {
+                const big_int a = random_bits(rng, bits);
+                const big_int n = random_odd_bits(rng, bits);
+                volatile int result = 0;
+                return time_ns([&] { result = CryptoService::JacobiSymbol(a, n); });
+            });
+        }
+    }
+
+    template <typename Test>
+    void bench_iteration(BenchRunner& runner, const std::string& name, int bits) {
+        const big_int n = iteration_modulus(bits);
+        const MontgomeryContext ctx(n);
+        const SingleIteration<Test> test;
+        runner.run(name + "::PerformSingleIteration", bits, [&](size_t) {
+            volatile bool passed = false;
+            return time_ns([&] { passed = test.PerformSingleIteration(n, ctx); });
+        });
+    }
+
+    void bench_primality(BenchRunner& runner, const BenchOptions& options) {
+        for (int bits : bit_sizes(options.max_bits)) {
+            bench_iteration<FermatTest>(runner, "FermatTest", bits);
+            bench_iteration<SolovayStrassenTest>(runner, "SolovayStrassenTest", bits);
+            bench_iteration<MillerRabinTest>(runner, "MillerRabinTest", bits);
+            bench_iteration<BailliePSWTest>(runner, "BailliePSWTest", bits);
+        }
+    }
+
+    void bench_rsa(BenchRunner& runner, const BenchOptions& options) {
+        const std::pair<RsaService::PrimalityTestType, const char*> types[] = {
+                {RsaService::MILLER_RABIN, "MILLER_RABIN"},
+                {RsaService::BAILLIE_PSW, "BAILLIE_PSW"},
+        };
+        for (int bits : bit_sizes(options.max_key_bits)) {
+            for (const auto& [type, type_name] : types) {
+                const std::string prime_name = std::string("RsaService::GeneratePrime/") + type_name;
+                const std::string keys_name = std::string("RsaService::GenerateKeys/") + type_name;
+                if (!runner.selected(prime_name + "/" + std::to_string(bits)) &&
+                    !runner.selected(keys_name + "/" + std::to_string(bits))) {
+                    continue;
+                }
+                // Конструктор с seed генерирует первый ключ (вне замера); дальше вызовы идут подряд
+                // по той же последовательности, так что выборка воспроизводима
+                RsaService generator(type, PROBABILITY, bits / 2, options.seed);
+                generator.SetKeyGenerationVerbose(false);
+                generator.SetKeyGenerationThreads(options.threads);
+                runner.run_fixed(prime_name, bits, options.keygen_runs, [&](size_t) {
+                    big_int prime;
+                    return time_ns([&] { prime = generator.GeneratePrime(); });
+                });
+                runner.run_fixed(keys_name, bits, options.keygen_runs, [&](size_t) {
+                    return time_ns([&] { generator.GenerateKeys(); });
+                });
+            }
+
+            const bool need_service = runner.selected("RsaService::Encrypt/" + std::to_string(bits)) ||
+                                      runner.selected("RsaService::Decrypt/" + std::to_string(bits)) ||
+                                      runner.selected("WienerAttackService::Attack/strong/" + std::to_string(bits)) ||
+                                      runner.selected("WienerAttackService::Attack/weak/" + std::to_string(bits));
+            if (!need_service) {
+                continue;
+            }
+            RsaService service(RsaService::MILLER_RABIN, PROBABILITY, bits / 2, options.seed);
+            service.SetKeyGenerationThreads(options.threads);
+            const big_int n = service.GetPublicKey().n;
+            ChaCha20Random rng(options.seed, static_cast<uint64_t>(bits) + 2);
+            runner.run("RsaService::Encrypt", bits, [&](size_t) {
+                const big_int message = rng.Uniform(2, n - 1);
+                big_int ciphertext;
+                return time_ns([&] { ciphertext = service.Encrypt(message); });
+            });
+            runner.run("RsaService::Decrypt", bits, [&](size_t) {
+                const big_int ciphertext = rng.Uniform(2, n - 1);
+                big_int message;
+                return time_ns([&] { message = service.Decrypt(ciphertext); });
+            });
+
+            // Сильный ключ - разложение e/n до конца; слабый - атака останавливается на найденном d
+            const RsaPublicKey strong_key = service.GetPublicKey();
+            runner.run("WienerAttackService::Attack/strong", bits, [&](size_t) {
+                WienerAttackResult result;
+                return time_ns([&] { result = WienerAttackService::Attack(strong_key); });
+            });
+            if (runner.selected("WienerAttackService::Attack/weak/" + std::to_string(bits))) {
+                service.GenerateWeakKeys();
+                const RsaPublicKey weak_key = service.GetPublicKey();
+                runner.run("WienerAttackService::Attack/weak", bits, [&](size_t) {
+                    WienerAttackResult result;
+                    return time_ns([&] { result = WienerAttackService::Attack(weak_key); });
+                });
+            }
+        }
+    }
+
+    BenchOptions parse_options(int argc, char** argv) {
+        BenchOptions options;
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("Не задано значение для " + arg);
+            }
+            const std::string value = argv[++i];
+            if (arg == "--filter") options.filter = value;
+            else if (arg == "--seed") options.seed = std::stoull(value);
+            else if (arg == "--samples") options.samples = std::stoul(value);
+            else if (arg == "--max-time") options.max_time = std::stod(value);
+            else if (arg == "--max-bits") options.max_bits = std::stoi(value);
+            else if (arg == "--max-key-bits") options.max_key_bits = std::stoi(value);
+            else if (arg == "--keygen-runs") options.keygen_runs = std::stoul(value);
+            else if (arg == "--threads") options.threads = static_cast<unsigned>(std::stoul(value));
+            else if (arg == "--out") options.out = value;
+            else throw std::invalid_argument("Неизвестный параметр: " + arg);
+        }
+        if (options.samples == 0 || options.keygen_runs == 0) {
+            throw std::invalid_argument("Число выборок должно быть положительным");
+        }
+        return options;
+    }
+}
+
+int main(int argc, char** argv) {
+    // RsaService пишет ход генерации ключей в std::cout: stdout остается только для JSON
+    std::ostream json_stdout(std::cout.rdbuf());
+    std::cout.rdbuf(nullptr);
+    try {
+        const BenchOptions options = parse_options(argc, argv);
+        BenchRunner runner(options);
+
+        bench_number_theory(runner, options);
+        bench_primality(runner, options);
+        bench_rsa(runner, options);
+
+        if (options.out.empty()) {
+            runner.write_json(json_stdout);
+        } else {
+            std::ofstream out(options.out);
+            runner.write_json(out);
+            if (!out) {
+                throw std::runtime_error("Не удалось записать " + options.out);
+            }
+        }
+    }
+    catch (const std::exception& ex) {
+        std::cerr << "Ошибка: " << ex.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -19,13 +19,18 @@ int main() {
     FermatTest fermat_test;
     SolovayStrassenTest ss_test;
     MillerRabinTest mr_test;
+    MillerRabinTest mr_bpsw_test(true);
+    BailliePSWTest bpsw_test;
 
     std::vector<TestCase> test_cases = {
             {"13", "Маленькое простое число"},
             {"15", "Маленькое составное число (3*5)"},
             {"999999937", "Большое простое число"},
             {"100160063", "Большое составное число (10007*10009)"},
-            {"561", "Число Кармайкла (3*11*17) - должно обмануть тест Ферма"}
+            {"561", "Число Кармайкла (3*11*17) - должно обмануть тест Ферма"},
+            {"3215031751", "Сильное псевдопростое по основаниям 2, 3, 5, 7"},
+            {"618970019642690137449562111", "Простое Мерсенна 2^89 - 1 (выше детерминированной границы M-R)"},
+            {"618970019642690137449562113", "Составное 2^89 + 1"}
     };
 
     double probability = 0.9999;
@@ -48,6 +53,14 @@ int main() {
             std::cout << std::left << std::setw(30) << "Тест Миллера-Рабина:"
                       << (mr_result ? "Вероятно простое" : "Составное") << std::endl;
 
+            bool mr_bpsw_result = mr_bpsw_test.IsPrime(n, probability);
+            std::cout << std::left << std::setw(30) << "Миллер-Рабин + BPSW:"
+                      << (mr_bpsw_result ? "Вероятно простое" : "Составное") << std::endl;
+
+            bool bpsw_result = bpsw_test.IsPrime(n, probability);
+            std::cout << std::left << std::setw(30) << "Тест Бэйли-PSW:"
+                      << (bpsw_result ? "Вероятно простое" : "Составное") << std::endl;
+
         } catch (const std::exception& e) {
             std::cerr << "Произошла ошибка: " << e.what() << std::endl;
         }
@@ -1,6 +1,11 @@
 #include <iostream>
+#include <sstream>
 #include "RsaService.h"
+#include "RsaKeyPool.h"
 #include "WienerAttackService.h" // <-- Подключаем наш новый сервис
+#include "BonehDurfeeAttackService.h"
+#include "BatchGcdService.h"
+#include "FermatAttackService.h"
 
 int main() {
     setlocale(LC_ALL, "Russian");
@@ -17,6 +22,11 @@ int main() {
         if (data1 == decrypted1) std::cout << "Успех: данные совпадают." << std::endl;
         else std::cout << "Ошибка: данные не совпадают." << std::endl;
 
+        std::cout << "ТЕСТ 1.1: ключ 512 бит на тесте Бэйли-PSW" << std::endl;
+        RsaService rsa_bpsw(RsaService::BAILLIE_PSW, 0.999, 512);
+        if (rsa_bpsw.Decrypt(rsa_bpsw.Encrypt(data1)) == data1) std::cout << "Успех: данные совпадают." << std::endl;
+        else std::cout << "Ошибка: данные не совпадают." << std::endl;
+
 
 
         std::cout << "ТЕСТ 2: шифрование данных разного размера (ключ 512 бит)" << std::endl;
@@ -37,6 +47,85 @@ int main() {
         else std::cout << "Ошибка: есть ошибки в расшифровке." << std::endl;
 
 
+        std::cout << "ТЕСТ 2.1: расшифрование и подпись по КТО" << std::endl;
+        RsaPrivateKey priv_multi = rsa_multi.GetPrivateKey();
+        big_int crt_data("31415926535897932384626433832795028841971");
+        big_int crt_cipher = rsa_multi.Encrypt(crt_data);
+        big_int plain_decrypted = CryptoService::ModPow(crt_cipher, priv_multi.d, priv_multi.n);
+        rsa_multi.SetParallelCrt(true);
+        big_int parallel_decrypted = rsa_multi.Decrypt(crt_cipher);
+        rsa_multi.SetParallelCrt(false);
+        big_int signature = rsa_multi.Sign(crt_data);
+        if (rsa_multi.Decrypt(crt_cipher) == plain_decrypted && parallel_decrypted == crt_data
+            && rsa_multi.Verify(crt_data, signature) && !rsa_multi.Verify(crt_data + 1, signature)) {
+            std::cout << "Успех: КТО совпадает с обычным возведением в степень, подпись проверена." << std::endl;
+        } else {
+            std::cout << "Ошибка: результат по КТО расходится с обычным возведением в степень." << std::endl;
+        }
+
+
+        std::cout << "ТЕСТ 2.2: пакетное шифрование/расшифрование" << std::endl;
+        std::vector<big_int> batch;
+        for (int i = 0; i < 64; ++i) {
+            batch.push_back(big_int(1000003) * i + 7);
+        }
+        std::vector<big_int> batch_encrypted = rsa_multi.EncryptBatch(batch);
+        std::vector<big_int> batch_decrypted = rsa_multi.DecryptBatch(batch_encrypted);
+        bool batch_ok = batch_decrypted == batch;
+        for (size_t i = 0; i < batch.size() && batch_ok; ++i) {
+            batch_ok = batch_encrypted[i] == rsa_multi.Encrypt(batch[i]);
+        }
+        if (batch_ok) std::cout << "Успех: пакетные результаты совпадают с поэлементными и идут в исходном порядке." << std::endl;
+        else std::cout << "Ошибка: пакетные результаты расходятся с поэлементными." << std::endl;
+
+        std::cout << "ТЕСТ 2.3: воспроизводимость генерации по seed" << std::endl;
+        RsaService rsa_seeded_a(RsaService::MILLER_RABIN, 0.999, 512, 20251026);
+        RsaService rsa_seeded_b(RsaService::MILLER_RABIN, 0.999, 512, 20251026);
+        rsa_seeded_a.SetKeyGenerationThreads(1);
+        rsa_seeded_b.SetKeyGenerationThreads(4);
+        rsa_seeded_a.GenerateKeys();
+        rsa_seeded_b.GenerateKeys();
+        if (rsa_seeded_a.GetPublicKey().n == rsa_seeded_b.GetPublicKey().n &&
+            rsa_seeded_a.GetPrivateKey().d == rsa_seeded_b.GetPrivateKey().d) {
+            std::cout << "Успех: одинаковый seed дает одинаковые ключи при любом числе потоков." << std::endl;
+        } else {
+            std::cout << "Ошибка: ключи с одинаковым seed различаются." << std::endl;
+        }
+
+        std::cout << "ТЕСТ 2.4: пул готовых ключей" << std::endl;
+        RsaKeyPool::Config pool_config;
+        pool_config.low_watermark = 1;
+        pool_config.high_watermark = 2;
+        RsaKeyPool pool(pool_config);
+        pool.Reserve(256, RsaService::MILLER_RABIN);
+        bool pool_ok = true;
+        for (int i = 0; i < 3; ++i) {
+            RsaService rsa_pooled(pool, RsaService::MILLER_RABIN, 256);
+            pool_ok = pool_ok && rsa_pooled.Decrypt(rsa_pooled.Encrypt(data1)) == data1;
+        }
+        RsaKeyPool::Stats pool_stats = pool.GetStats(256, RsaService::MILLER_RABIN);
+        pool_ok = pool_ok && pool_stats.served == 3 && pool_stats.generated >= 3 &&
+                  pool_stats.ready <= pool_config.high_watermark;
+        if (pool_ok) std::cout << "Успех: ключи из пула рабочие, статистика сходится." << std::endl;
+        else std::cout << "Ошибка: пул ключей работает неверно." << std::endl;
+
+        // Исключение фонового потока (здесь - недопустимая вероятность в тесте простоты)
+        // должно дойти до Acquire, а не завершить процесс или оставить Acquire ждать вечно
+        RsaKeyPool::Config failing_config;
+        failing_config.probability = 0.3;
+        RsaKeyPool failing_pool(failing_config);
+        int pool_errors = 0;
+        for (int i = 0; i < 2; ++i) {
+            try {
+                failing_pool.Acquire(256, RsaService::MILLER_RABIN);
+            } catch (const std::invalid_argument&) {
+                ++pool_errors;
+            }
+        }
+        if (pool_errors == 2) std::cout << "Успех: исключение фоновой генерации передано в Acquire." << std::endl;
+        else std::cout << "Ошибка: исключение фоновой генерации не передано в Acquire." << std::endl;
+
+
         std::cout << "ТЕСТ 3: проверка ключа на уязвимость к атаке Винера" << std::endl;
         std::cout << "Атакуем сильный ключ" << std::endl;
         RsaPublicKey pubKey_safe = rsa_multi.GetPublicKey();
@@ -75,6 +164,103 @@ int main() {
             std::cout << "\nОшибка: атака на слабый ключ не удалась.\n";
         }
 
+        std::cout << "ТЕСТ 5: пакетная проверка ключей на атаку Винера" << std::endl;
+        std::stringstream corpus;
+        corpus << "# n e\n" << pubKey_safe.n << " " << pubKey_safe.e << "\n"
+               << pubKey_weak.n << " " << pubKey_weak.e << "\n";
+        std::vector<WienerScanHit> hits = WienerAttackService::Scan(corpus);
+        if (hits.size() == 1 && hits[0].index == 1 && hits[0].result.found_d == privKey_weak.d) {
+            std::cout << "Успех: найден только слабый ключ." << std::endl;
+        } else {
+            std::cout << "Ошибка: пакетная проверка вернула неверный результат." << std::endl;
+        }
+
+        std::cout << "ТЕСТ 6: атака Боне-Дурфи на d ~ n^0.26 (вне досягаемости атаки Винера)" << std::endl;
+        // Фиксированный seed: ключ воспроизводим, тест не зависит от того, насколько d вышло меньше n^0.26
+        RsaService rsa_bd(RsaService::MILLER_RABIN, 0.999, 256, 20251027);
+        rsa_bd.GenerateWeakKeys(0.26);
+        RsaPublicKey pubKey_bd = rsa_bd.GetPublicKey();
+        RsaPrivateKey privKey_bd = rsa_bd.GetPrivateKey();
+        const bool wiener_bd = WienerAttackService::Attack(pubKey_bd).success;
+        // m подбирается автоматически (для n из 512 бит - 6 или 7); при m = 5 определитель решетки велик
+        BonehDurfeeAttackResult bd_result = BonehDurfeeAttackService::Attack(pubKey_bd, 0.26);
+        std::cout << "  m = " << bd_result.m << ", t = " << bd_result.t
+                  << ", размерность решетки: " << bd_result.lattice_dimension << std::endl;
+        if (!wiener_bd && !bd_result.insufficient_m && bd_result.success && bd_result.found_d == privKey_bd.d) {
+            std::cout << "Успех: атака Винера не справилась, атака Боне-Дурфи нашла d." << std::endl;
+        } else {
+            std::cout << "Ошибка: атака Боне-Дурфи не нашла d." << std::endl;
+        }
+        if (BonehDurfeeAttackService::Attack(pubKey_bd, 0.26, 5).insufficient_m) {
+            std::cout << "Успех: m = 5 помечено как недостаточное для n^0.26." << std::endl;
+        } else {
+            std::cout << "Ошибка: m = 5 не помечено как недостаточное для n^0.26." << std::endl;
+        }
+
+        std::cout << "ТЕСТ 7: пакетный НОД - модули с общим простым" << std::endl;
+        // 0 и 3 делят p, 1 и 4 совпадают, 2 ни с кем не связан; порог 0 выгружает все уровни на диск
+        const RsaPrivateKey& k1 = privKey_weak;
+        const RsaPrivateKey& k2 = privKey_bd;
+        const RsaPrivateKey k3 = rsa_basic.GetPrivateKey();
+        big_int fresh_prime;
+        mpz_nextprime(fresh_prime.backend().data(), k3.q.backend().data());
+        std::vector<RsaPublicKey> audit_keys = {
+                {k1.n, 65537}, {k2.n, 65537}, {k3.n, 65537}, {k1.p * fresh_prime, 65537}, {k2.n, 3}};
+        BatchGcdService::Options audit_options;
+        audit_options.spill_threshold = 0;
+        audit_options.threads = 2;
+        std::vector<SharedFactorHit> shared = BatchGcdService::Audit(audit_keys, audit_options);
+        bool audit_ok = shared.size() == 4 &&
+                        shared[0].index == 0 && shared[0].factor == k1.p && !shared[0].duplicate &&
+                        shared[1].index == 1 && shared[1].duplicate &&
+                        shared[2].index == 3 && shared[2].factor == k1.p &&
+                        shared[3].index == 4 && shared[3].duplicate;
+        audit_ok = audit_ok && BatchGcdService::Audit(audit_keys).size() == shared.size();
+        // Из потока ключи восстанавливаются по листовому уровню и сохраненным экспонентам
+        std::stringstream audit_stream;
+        for (const RsaPublicKey& key : audit_keys) {
+            audit_stream << key.n << " " << key.e << "\n";
+        }
+        std::vector<SharedFactorHit> streamed = BatchGcdService::Audit(audit_stream, audit_options);
+        audit_ok = audit_ok && streamed.size() == shared.size() &&
+                   streamed[2].key.n == audit_keys[3].n && streamed[3].key.e == 3 && streamed[3].duplicate;
+        if (audit_ok) {
+            std::cout << "Успех: найдены все модули с общим делителем и дубликаты." << std::endl;
+        } else {
+            std::cout << "Ошибка: пакетный НОД вернул неверный результат." << std::endl;
+        }
+
+        std::cout << "ТЕСТ 8: атака Ферма и порог близости p и q в генераторе" << std::endl;
+        // Ключ генератора не раскладывается; q рядом с p: при |p - q| < n^(1/4) хватает первого шага,
+        // при |p - q| ~ 2^8 * n^(1/4) - около 2^16 / 8 шагов
+        const uint64_t fermat_budget = uint64_t(1) << 16;
+        const bool strong_safe = !FermatAttackService::Attack({k3.n, 65537}, fermat_budget).success &&
+                                 FermatAttackService::StepsToFactor(k3.p, k3.q) > fermat_budget;
+        const size_t quarter_bits = mpz_sizeinbase(k3.p.backend().data(), 2) / 2;
+        big_int q_close, q_far;
+        const big_int close_start = k3.p + (big_int(1) << (quarter_bits - 2));
+        const big_int far_start = k3.p + (big_int(1) << (quarter_bits + 8));
+        mpz_nextprime(q_close.backend().data(), close_start.backend().data());
+        mpz_nextprime(q_far.backend().data(), far_start.backend().data());
+        const RsaPublicKey close_key{k3.p * q_close, 65537};
+        const RsaPublicKey far_key{k3.p * q_far, 65537};
+        FermatAttackResult close_result = FermatAttackService::Attack(close_key, fermat_budget);
+        FermatAttackResult far_result = FermatAttackService::Attack(far_key, fermat_budget, 3);
+        std::stringstream fermat_corpus;
+        fermat_corpus << k3.n << " 65537\n" << close_key.n << " 65537\n" << far_key.n << " 65537\n";
+        std::vector<FermatScanHit> fermat_hits = FermatAttackService::Scan(fermat_corpus, fermat_budget);
+        const bool fermat_ok = strong_safe &&
+                               close_result.success && close_result.steps == 0 && close_result.p == k3.p &&
+                               far_result.success && far_result.q == q_far &&
+                               far_result.steps == FermatAttackService::StepsToFactor(k3.p, q_far) &&
+                               fermat_hits.size() == 2 && fermat_hits[0].index == 1 && fermat_hits[1].index == 2;
+        std::cout << "  Шагов для |p - q| ~ 2^8 * n^(1/4): " << far_result.steps << std::endl;
+        if (fermat_ok) {
+            std::cout << "Успех: близкие p и q раскладываются, ключ генератора - нет." << std::endl;
+        } else {
+            std::cout << "Ошибка: атака Ферма работает неверно." << std::endl;
+        }
+
     } catch (const std::exception& e) {
         std::cerr << "Произошла критическая ошибка: " << e.what() << std::endl;
         return 1;
@@ -4,6 +4,9 @@
 
 #include <iostream>
 #include "StatelessService.h"
+#include "MontgomeryContext.h"
+#include "ChaCha20Random.h"
+#include <algorithm>
 
 void demonstrate_gcd() {
     std::cout << "НОД (Алгоритм Евклида)\n";
@@ -30,6 +33,16 @@ void demonstrate_mod_pow() {
     std::cout << std::endl;
 }
 
+void demonstrate_montgomery() {
+    std::cout << "Возведение в степень в форме Монтгомери\n";
+    big_int base("5"), exp("117"), mod("19");
+    MontgomeryContext ctx(mod);
+    big_int result = ctx.Pow(base, exp);
+    std::cout << base << "^" << exp << " mod " << mod << " = " << result
+              << (result == CryptoService::ModPow(base, exp, mod) ? " (совпадает с ModPow)" : " (НЕ совпадает с ModPow)") << std::endl;
+    std::cout << std::endl;
+}
+
 void demonstrate_legendre() {
     std::cout << "Символа Лежандра\n";
     big_int a1("2"), p1("7");
@@ -48,6 +61,147 @@ void demonstrate_jacobi() {
     std::cout << std::endl;
 }
 
+// Знаковые многолимбовые входы сверяются с GMP: mpz_gcd, mpz_gcdext (НОД и тождество Безу)
+// и mpz_jacobi. Общий множитель делает НОД нетривиальным, нули и единицы проверяют края
+bool check_against_gmp() {
+    std::cout << "Сверка НОД, расширенного НОД и символа Якоби с GMP\n";
+    gmp_randstate_t state;
+    gmp_randinit_mt(state);
+    gmp_randseed_ui(state, 40);
+    big_int a, b, common, n;
+    big_int expected, g, s, t, x, y;
+    int failures = 0;
+
+    auto random_signed = [&](big_int& value, mp_bitcnt_t max_bits) {
+        mpz_ptr z = value.backend().data();
+        mpz_urandomb(z, state, 1 + gmp_urandomm_ui(state, max_bits));
+        if (gmp_urandomm_ui(state, 2) != 0) {
+            mpz_neg(z, z);
+        }
+    };
+    auto report = [&](const char* what) {
+        if (++failures <= 5) {
+            std::cout << "Ошибка: " << what << " для a = " << a << ", b = " << b << std::endl;
+        }
+    };
+
+    for (int i = 0; i < 2000; ++i) {
+        random_signed(a, 640);
+        random_signed(b, 640);
+        random_signed(common, 200);
+        a *= common;
+        b *= common;
+        if (i % 100 == 0) a = 0;
+        if (i % 100 == 1) b = 0;
+        if (i % 100 == 2) b = (i % 200 == 2) ? 1 : -1;
+
+        mpz_gcd(expected.backend().data(), a.backend().data(), b.backend().data());
+        if (CryptoService::Gcd(a, b) != expected) {
+            report("Gcd");
+        }
+
+        mpz_gcdext(g.backend().data(), s.backend().data(), t.backend().data(), a.backend().data(), b.backend().data());
+        big_int d = CryptoService::ExtendedGcd(a, b, x, y);
+        if (d != g) {
+            report("ExtendedGcd (НОД)");
+        }
+        if (a * x + b * y != d) {
+            report("ExtendedGcd (тождество Безу)");
+        }
+
+        random_signed(n, 640);
+        n = abs(n);
+        mpz_setbit(n.backend().data(), 0);
+        if (i % 100 == 3) n = common * common | 1;
+        if (CryptoService::JacobiSymbol(a, n) != mpz_jacobi(a.backend().data(), n.backend().data())) {
+            report("JacobiSymbol");
+        }
+    }
+    gmp_randclear(state);
+
+    if (failures == 0) {
+        std::cout << "Все результаты совпадают с GMP" << std::endl;
+    }
+    std::cout << std::endl;
+    return failures == 0;
+}
+
+// RFC 8439, 2.3.2: 96-битный nonce и 32-битный счетчик раскладываются в 64-битные счетчик и номер потока
+// (слова 12-13 - счетчик, 14-15 - поток)
+bool check_chacha20_block() {
+    std::cout << "Блок ChaCha20 (RFC 8439, 2.3.2)\n";
+    std::array<uint32_t, 8> key{};
+    for (uint32_t i = 0; i < 8; ++i) {
+        key[i] = (4 * i) | (4 * i + 1) << 8 | (4 * i + 2) << 16 | (4 * i + 3) << 24;
+    }
+    const uint64_t counter = (uint64_t(0x09000000) << 32) | 1;
+    const uint64_t stream = 0x4a000000;
+    const uint32_t expected[16] = {
+            0xe4e7f110, 0x15593bd1, 0x1fdd0f50, 0xc47120a3,
+            0xc7f4d1c7, 0x0368c033, 0x9aaa2204, 0x4e6cd4c3,
+            0x466482d2, 0x09aa9f07, 0x05d7c214, 0xa2028bd9,
+            0xd19c12b5, 0xb94e16de, 0xe883d0cb, 0x4e3c50a2
+    };
+    uint32_t block[16];
+    ChaCha20Random::Block(key, counter, stream, block);
+    const bool ok = std::equal(block, block + 16, expected);
+    std::cout << (ok ? "Совпадает с эталоном" : "Ошибка: блок ChaCha20 не совпадает с эталоном RFC 8439") << std::endl;
+    std::cout << std::endl;
+    return ok;
+}
+
+// Uniform на границах, не являющихся степенью двойки: маска оставляет лишние значения, их должен
+// отбросить отбор. Малый диапазон проверяется по частотам, многолимбовый - по попаданию в обе половины
+bool check_uniform() {
+    std::cout << "Равномерная выборка ChaCha20Random::Uniform\n";
+    ChaCha20Random rng(41, 0);
+    bool ok = true;
+
+    const big_int min("-3"), max("2");
+    const int values = 6;
+    const int samples = 60000;
+    int counts[values] = {};
+    for (int i = 0; i < samples; ++i) {
+        const big_int r = rng.Uniform(min, max);
+        if (r < min || r > max) {
+            std::cout << "Ошибка: Uniform вернул " << r << " вне [" << min << ", " << max << "]" << std::endl;
+            return false;
+        }
+        ++counts[static_cast<int>(r - min)];
+    }
+    for (int v = 0; v < values; ++v) {
+        // ожидается 10000, стандартное отклонение около 91
+        if (counts[v] < 9500 || counts[v] > 10500) {
+            std::cout << "Ошибка: значение " << min + v << " выпало " << counts[v] << " раз из " << samples << std::endl;
+            ok = false;
+        }
+    }
+
+    // range = 3 * 2^128: старший лимб маскируется до 2 бит, отбрасывается четверть значений
+    const big_int big_min = -(big_int(1) << 100);
+    const big_int big_max = big_min + 3 * (big_int(1) << 128);
+    const big_int middle = big_min + 3 * (big_int(1) << 127);
+    int upper = 0;
+    for (int i = 0; i < 4000; ++i) {
+        const big_int r = rng.Uniform(big_min, big_max);
+        if (r < big_min || r > big_max) {
+            std::cout << "Ошибка: Uniform вернул " << r << " вне [" << big_min << ", " << big_max << "]" << std::endl;
+            return false;
+        }
+        upper += r > middle;
+    }
+    if (upper < 1800 || upper > 2200) {
+        std::cout << "Ошибка: в верхнюю половину многолимбового диапазона попало " << upper << " из 4000" << std::endl;
+        ok = false;
+    }
+
+    if (ok) {
+        std::cout << "Все значения в диапазоне, частоты равномерны" << std::endl;
+    }
+    std::cout << std::endl;
+    return ok;
+}
+
 int main() {
     setlocale(LC_ALL, "Russian");
 
@@ -55,8 +209,12 @@ int main() {
         demonstrate_gcd();
         demonstrate_extended_gcd();
         demonstrate_mod_pow();
+        demonstrate_montgomery();
         demonstrate_legendre();
         demonstrate_jacobi();
+        if (!check_against_gmp() || !check_chacha20_block() || !check_uniform()) {
+            return 1;
+        }
     } catch (const std::exception& e) {
         std::cerr << "Произошла ошибка: " << e.what() << std::endl;
         return 1;